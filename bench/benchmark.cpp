@@ -0,0 +1,425 @@
+#include <hsm.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <new>
+#include <string>
+#include <vector>
+
+// usage: benchmark [iterations]
+// prints JSON: ns/event and allocs/event of every scenario
+
+static std::atomic<std::size_t> allocs{};
+
+void *operator new( std::size_t size_ )
+{
+	allocs.fetch_add(1, std::memory_order_relaxed);
+	if (void *ptr_ = std::malloc(size_ ? size_ : 1))
+		return ptr_;
+	throw std::bad_alloc();
+}
+
+void operator delete( void *ptr_ ) noexcept { std::free(ptr_); }
+void operator delete( void *ptr_, std::size_t ) noexcept { std::free(ptr_); }
+
+static volatile unsigned sink;
+static void count( const hsm::Message& message_ ) { sink = sink + message_.event; }
+
+static std::size_t iterations = 1000000;
+static bool first = true;
+
+enum Event
+{
+	Exit  = hsm::Event::Exit,
+	Entry = hsm::Event::Entry,
+	Init  = hsm::Event::Init,
+	Hit   = hsm::Event::User,
+	Miss,
+	Other,
+	Left,
+	Right,
+	Power,
+	Stop,
+	Play,
+	Pause,
+	Rec,
+	Rew,
+	FF,
+};
+
+/* -------------------------------------------------------------------------- */
+
+template<class F>
+static void report( const char *name_, const char *tree_, std::size_t param_, std::size_t events_, F&& function_ )
+{
+	std::size_t allocs_ = allocs.load(std::memory_order_relaxed);
+	auto start_ = std::chrono::steady_clock::now();
+	function_();
+	auto stop_ = std::chrono::steady_clock::now();
+	allocs_ = allocs.load(std::memory_order_relaxed) - allocs_;
+
+	double ns_ = std::chrono::duration<double, std::nano>(stop_ - start_).count();
+
+	std::printf("%s\n    {\"name\": \"%s\", \"tree\": \"%s\", \"param\": %zu, \"events\": %zu, \"ns_per_event\": %.3f, \"allocs_per_event\": %.6f}",
+		first ? "" : ",", name_, tree_, param_, events_, ns_ / static_cast<double>(events_), static_cast<double>(allocs_) / static_cast<double>(events_));
+
+	first = false;
+}
+
+/* -------------------------------------------------------------------------- */
+
+// chain of 'depth' nested states: states[0] is the root, states.back() is the leaf
+static void chain( std::deque<hsm::State>& states_, std::size_t depth_ )
+{
+	states_.emplace_back();
+	while (states_.size() < depth_)
+		states_.emplace_back(states_.back());
+}
+
+static void deep( std::size_t depth_ )
+{
+	std::deque<hsm::State> states_;
+	chain(states_, depth_);
+	hsm::State& root_ = states_.front();
+	hsm::State& leaf_ = states_.back();
+
+	{
+		hsm::Definition def_{{
+			{ root_, Event::Miss,  count },
+			{ leaf_, Event::Hit,   count },
+			{ leaf_, hsm::Event::ALL, count },
+		}};
+		hsm::StateMachine hsm_{def_};
+		hsm_.start(leaf_);
+
+		report("leaf_hit", "deep", depth_, iterations, [&]{
+			for (std::size_t i = 0; i < iterations; i++) hsm_.message({Event::Hit});
+		});
+
+		report("all_fallback", "deep", depth_, iterations, [&]{
+			for (std::size_t i = 0; i < iterations; i++) hsm_.message({Event::Other});
+		});
+	}
+
+	{
+		hsm::Definition def_{{
+			{ root_, Event::Miss,  count },
+			{ leaf_, Event::Hit,   count },
+		}};
+		hsm::StateMachine hsm_{def_};
+		hsm_.start(leaf_);
+
+		report("root_hit_after_miss", "deep", depth_, iterations, [&]{
+			for (std::size_t i = 0; i < iterations; i++) hsm_.message({Event::Miss});
+		});
+
+		report("unhandled", "deep", depth_, iterations, [&]{
+			for (std::size_t i = 0; i < iterations; i++) hsm_.message({Event::Other});
+		});
+	}
+}
+
+static void lca( std::size_t depth_ )
+{
+	std::deque<hsm::State> states_;
+	hsm::State& top_ = states_.emplace_back();
+	hsm::State *left_ = &top_;
+	hsm::State *right_ = &top_;
+	for (std::size_t i = 1; i < depth_; i++)
+	{
+		left_ = &states_.emplace_back(*left_);
+		right_ = &states_.emplace_back(*right_);
+	}
+
+	hsm::State& l_ = *left_;
+	hsm::State& r_ = *right_;
+
+	{
+		hsm::Definition def_{{
+			{ l_, Event::Right, r_ },
+			{ r_, Event::Left,  l_ },
+			{ l_, Event::Entry, count },
+			{ r_, Event::Entry, count },
+		}};
+		hsm::StateMachine hsm_{def_};
+		hsm_.start(l_);
+
+		report("lca_transition_direct", "lca", depth_, iterations, [&]{
+			for (std::size_t i = 0; i < iterations; i += 2) { hsm_.message({Event::Right}); hsm_.message({Event::Left}); }
+		});
+	}
+
+	{
+		hsm::Definition def_{{
+			{ l_, Event::Right, [&](const hsm::Message& m){ m.hsm->transition(r_); } },
+			{ r_, Event::Left,  [&](const hsm::Message& m){ m.hsm->transition(l_); } },
+			{ l_, Event::Entry, count },
+			{ r_, Event::Entry, count },
+		}};
+		hsm::StateMachine hsm_{def_};
+		hsm_.start(l_);
+
+		report("lca_transition_handler", "lca", depth_, iterations, [&]{
+			for (std::size_t i = 0; i < iterations; i += 2) { hsm_.message({Event::Right}); hsm_.message({Event::Left}); }
+		});
+	}
+}
+
+static void init( std::size_t depth_ )
+{
+	std::deque<hsm::State> states_;
+	hsm::State& off_ = states_.emplace_back();
+	chain(states_, depth_ + 1);
+
+	std::vector<hsm::Action> tab_{
+		{ off_, Event::Power, states_[1] },
+		{ states_[1], Event::Power, off_ },
+	};
+	for (std::size_t i = 1; i + 1 < states_.size(); i++)
+		tab_.push_back({ states_[i], Event::Init, states_[i + 1] });
+	tab_.push_back({ states_.back(), Event::Entry, count });
+
+	hsm::Definition def_{tab_};
+	hsm::StateMachine hsm_{def_};
+	hsm_.start(off_);
+
+	report("init_chain", "deep", depth_, iterations, [&]{
+		for (std::size_t i = 0; i < iterations; i++) hsm_.message({Event::Power});
+	});
+}
+
+static void wide( std::size_t width_ )
+{
+	std::deque<hsm::State> states_;
+	hsm::State& top_ = states_.emplace_back();
+	std::vector<hsm::Action> tab_;
+	for (std::size_t i = 0; i < width_; i++)
+	{
+		hsm::State& state_ = states_.emplace_back(top_);
+		tab_.push_back({ state_, Event::Entry, count });
+		tab_.push_back({ state_, Event::Exit,  count });
+		tab_.push_back({ state_, Event::Hit,   count });
+		tab_.push_back({ state_, static_cast<unsigned>(Event::FF + 1 + i % 64), count });
+	}
+	tab_.push_back({ top_, Event::Init, states_.back() });
+
+	hsm::Definition def_{tab_};
+	std::size_t count_ = iterations / (width_ * 10) + 1;
+
+	report("definition_compile", "wide", width_, count_, [&]{
+		for (std::size_t i = 0; i < count_; i++) { hsm::Definition d_{tab_}; }
+	});
+
+	report("start_shared_definition", "wide", width_, count_ * 10, [&]{
+		for (std::size_t i = 0; i < count_ * 10; i++) { hsm::StateMachine hsm_{def_}; hsm_.start(top_); }
+	});
+
+	report("start_private_definition", "wide", width_, count_, [&]{
+		for (std::size_t i = 0; i < count_; i++) { hsm::StateMachine hsm_{tab_}; hsm_.start(top_); }
+	});
+
+	hsm::StateMachine hsm_{def_};
+	hsm_.start(top_);
+
+	report("leaf_hit", "wide", width_, iterations, [&]{
+		for (std::size_t i = 0; i < iterations; i++) hsm_.message({Event::Hit});
+	});
+}
+
+static void vcr()
+{
+	auto StateOff             = hsm::State();
+	auto StateIdle            = hsm::State();
+	auto StateIdleStop        = hsm::State(StateIdle);
+	auto StateIdleFF          = hsm::State(StateIdle);
+	auto StateIdleRew         = hsm::State(StateIdle);
+	auto StatePlaying         = hsm::State();
+	auto StatePlayingPlay     = hsm::State(StatePlaying);
+	auto StatePlayingPause    = hsm::State(StatePlaying);
+	auto StateRecording       = hsm::State();
+	auto StateRecordingRecord = hsm::State(StateRecording);
+	auto StateRecordingPause  = hsm::State(StateRecording);
+
+	hsm::Definition def_
+	{{
+		{ StateOff,             Event::Entry,   count },
+		{ StateOff,             Event::Exit,    count },
+		{ StateOff,             Event::Power,   StateIdle },
+		{ StateIdle,            Event::Entry,   count },
+		{ StateIdle,            Event::Exit,    count },
+		{ StateIdle,            Event::Init,    StateIdleStop },
+		{ StateIdle,            Event::Power,   StateOff },
+		{ StateIdle,            Event::Play,    StatePlaying },
+		{ StateIdle,            Event::Rec,     StateRecording },
+		{ StateIdleStop,        Event::Entry,   count },
+		{ StateIdleStop,        Event::Rew,     StateIdleRew },
+		{ StateIdleStop,        Event::FF,      StateIdleFF },
+		{ StateIdleRew,         Event::Entry,   count },
+		{ StateIdleRew,         Event::Stop,    StateIdle },
+		{ StateIdleFF,          Event::Entry,   count },
+		{ StateIdleFF,          Event::Stop,    StateIdle },
+		{ StatePlaying,         Event::Entry,   count },
+		{ StatePlaying,         Event::Exit,    count },
+		{ StatePlaying,         Event::Init,    StatePlayingPlay },
+		{ StatePlaying,         Event::Power,   StateOff },
+		{ StatePlaying,         Event::Stop,    StateIdle },
+		{ StatePlayingPlay,     Event::Entry,   count },
+		{ StatePlayingPlay,     Event::Pause,   StatePlayingPause },
+		{ StatePlayingPause,    Event::Entry,   count },
+		{ StatePlayingPause,    Event::Play,    StatePlayingPlay },
+		{ StateRecording,       Event::Entry,   count },
+		{ StateRecording,       Event::Exit,    count },
+		{ StateRecording,       Event::Init,    StateRecordingRecord },
+		{ StateRecording,       Event::Power,   StateOff },
+		{ StateRecording,       Event::Stop,    StateIdle },
+		{ StateRecordingRecord, Event::Entry,   count },
+		{ StateRecordingRecord, Event::Pause,   StateRecordingPause },
+		{ StateRecordingPause,  Event::Entry,   count },
+		{ StateRecordingPause,  Event::Rec,     StateRecordingRecord },
+	}};
+
+	static const unsigned script_[] = { Power, Rew, Stop, Play, Pause, Play, Stop, Rew, Stop, Rec, Pause, Rec, Stop, FF, Stop, Power };
+	const std::size_t length_ = sizeof(script_) / sizeof(*script_);
+	std::size_t count_ = iterations / length_ + 1;
+
+	hsm::StateMachine hsm_{def_};
+	hsm_.start(StateOff);
+
+	report("vcr_script", "vcr", length_, count_ * length_, [&]{
+		for (std::size_t i = 0; i < count_; i++)
+			for (unsigned event_: script_)
+				hsm_.message({event_});
+	});
+
+	report("vcr_start", "vcr", 11, count_, [&]{
+		for (std::size_t i = 0; i < count_; i++) { hsm::StateMachine h_{def_}; h_.start(StateOff); }
+	});
+}
+
+static void array( std::size_t count_ )
+{
+	hsm::State off_;
+	hsm::State on_;
+	hsm::State on_idle_(on_);
+	hsm::State on_busy_(on_);
+
+	hsm::Definition def_{{
+		{ off_,      Event::Power, on_ },
+		{ on_,       Event::Init,  on_idle_ },
+		{ on_,       Event::Power, off_ },
+		{ on_idle_,  Event::Play,  on_busy_ },
+		{ on_busy_,  Event::Stop,  on_idle_ },
+		{ on_busy_,  Event::Hit,   count },
+	}};
+
+	static const unsigned script_[] = { Power, Play, Hit, Stop, Play, Power };
+	const std::size_t length_ = sizeof(script_) / sizeof(*script_);
+	std::size_t rounds_ = iterations / (count_ * length_) + 1;
+
+	std::vector<std::size_t> idx_(count_);
+	std::vector<hsm::Message> tab_(count_);
+	for (std::size_t i = 0; i < count_; i++)
+		idx_[i] = count_ - 1 - i;
+
+	hsm::StateMachineArray hsm_{def_, count_};
+	hsm_.start(off_);
+
+	report("array_single", "array", count_, rounds_ * length_ * count_, [&]{
+		for (std::size_t r = 0; r < rounds_; r++)
+			for (unsigned event_: script_)
+				for (std::size_t i = 0; i < count_; i++)
+					hsm_.message(i, {event_});
+	});
+
+	report("array_batch", "array", count_, rounds_ * length_ * count_, [&]{
+		for (std::size_t r = 0; r < rounds_; r++)
+			for (unsigned event_: script_)
+			{
+				std::fill(tab_.begin(), tab_.end(), hsm::Message{event_});
+				hsm_.message(tab_.data());
+			}
+	});
+
+	report("array_batch_indexed", "array", count_, rounds_ * length_ * count_, [&]{
+		for (std::size_t r = 0; r < rounds_; r++)
+			for (unsigned event_: script_)
+			{
+				std::fill(tab_.begin(), tab_.end(), hsm::Message{event_});
+				hsm_.message(idx_.data(), tab_.data(), count_);
+			}
+	});
+}
+
+static void live( std::size_t count_ )
+{
+	hsm::State off_;
+	hsm::State on_;
+	hsm::State on_idle_(on_);
+	hsm::State on_busy_(on_);
+
+	hsm::LiveDefinition def_{{
+		{ off_,      Event::Power, on_ },
+		{ on_,       Event::Init,  on_idle_ },
+		{ on_,       Event::Power, off_ },
+		{ on_idle_,  Event::Play,  on_busy_ },
+		{ on_busy_,  Event::Stop,  on_idle_ },
+		{ on_busy_,  Event::Hit,   count },
+	}};
+
+	std::deque<hsm::MessageQueue<4>> queues_(count_);
+	std::deque<hsm::StateMachine> hsm_;
+	for (std::size_t i = 0; i < count_; i++)
+	{
+		hsm::StateMachine& h_ = hsm_.emplace_back(def_);
+		h_.attach(queues_[i]);
+		h_.start(on_);
+		h_.message({Event::Play});
+	}
+
+	std::size_t rounds_ = iterations / count_ + 1;
+
+	report("live_message", "live", count_, rounds_ * count_, [&]{
+		for (std::size_t r = 0; r < rounds_; r++)
+			for (auto& h_: hsm_)
+				h_.message({Event::Hit});
+	});
+
+	rounds_ = rounds_ / 100 + 1;
+
+	report("live_patch_switch", "live", count_, rounds_ * count_, [&]{
+		for (std::size_t r = 0; r < rounds_; r++)
+		{
+			def_.patch({ { on_busy_, Event::Hit, count } });
+			for (auto& h_: hsm_)
+				h_.message({Event::Hit});
+		}
+	});
+}
+
+/* -------------------------------------------------------------------------- */
+
+int main( int argc, char *argv[] )
+{
+	if (argc > 1)
+		iterations = std::strtoul(argv[1], nullptr, 10);
+
+	std::printf("{\n  \"library\": \"hsm\",\n  \"iterations\": %zu,\n  \"benchmarks\": [", iterations);
+
+	for (std::size_t depth_: { 1u, 4u, 16u, 64u })
+		deep(depth_);
+	for (std::size_t depth_: { 2u, 8u, 32u })
+		lca(depth_);
+	for (std::size_t depth_: { 1u, 4u, 16u })
+		init(depth_);
+	for (std::size_t width_: { 8u, 64u, 512u })
+		wide(width_);
+	vcr();
+	for (std::size_t count_: { 64u, 4096u })
+		array(count_);
+	for (std::size_t count_: { 64u, 4096u })
+		live(count_);
+
+	std::printf("\n  ]\n}\n");
+}
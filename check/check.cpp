@@ -0,0 +1,847 @@
+#include <hsm.hpp>
+#include <hsmenum.hpp>
+#include <hsminbox.hpp>
+#include <hsmstatic.hpp>
+#if defined(__cpp_impl_coroutine)
+#include <hsmcoro.hpp>
+#endif
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+// usage: check
+// runs every scenario and compares the observable sequence of handlers and states with the expected one;
+// the exit status is the number of failed scenarios
+
+static std::string out;
+static unsigned failed = 0;
+
+static void expect( const char *name_, const std::string& result_, const char *expected_ )
+{
+	if (result_ == expected_)
+		std::printf("ok      %s\n", name_);
+	else
+	{
+		std::printf("FAILED  %s\n    expected: %s\n    result:   %s\n", name_, expected_, result_.c_str());
+		failed++;
+	}
+}
+
+template<const char *Text>
+static void print( const hsm::Message& ) { out += Text; out += ' '; }
+
+static void mark( const char *text_ ) { out += text_; out += ' '; }
+
+enum Event : unsigned
+{
+	Exit  = hsm::Event::Exit,
+	Entry = hsm::Event::Entry,
+	Init  = hsm::Event::Init,
+	Power = hsm::Event::User,
+	Stop,
+	Play,
+	Pause,
+	Rec,
+	Rew,
+	FF,
+	Go,
+	Back,
+	Ping,
+	Last,
+};
+
+/* -------------------------------------------------------------------------- */
+
+static constexpr char EnterOff[]       = "[Off";
+static constexpr char ExitOff[]        = "Off]";
+static constexpr char EnterIdle[]      = "[Idle";
+static constexpr char ExitIdle[]       = "Idle]";
+static constexpr char EnterStop[]      = "[Stop";
+static constexpr char EnterRew[]       = "[Rew";
+static constexpr char EnterFF[]        = "[FF";
+static constexpr char EnterPlaying[]   = "[Playing";
+static constexpr char ExitPlaying[]    = "Playing]";
+static constexpr char EnterPlay[]      = "[Play";
+static constexpr char EnterPause[]     = "[Pause";
+static constexpr char EnterRecording[] = "[Recording";
+static constexpr char ExitRecording[]  = "Recording]";
+static constexpr char EnterRecord[]    = "[Record";
+static constexpr char EnterRecPause[]  = "[RecPause";
+
+static const unsigned script[] = { Power, Rew, Stop, Play, Pause, Play, Stop, FF, Stop, Rec, Pause, Rec, Stop, Power, hsm::Event::Stop };
+
+static const char vcr_log[] =
+	"[Off Off] [Idle [Stop [Rew [Stop Idle] [Playing [Play [Pause [Play Playing] [Idle [Stop [FF [Stop "
+	"Idle] [Recording [Record [RecPause [Record Recording] [Idle [Stop Idle] [Off Off] ";
+
+hsm::State StateOff;
+hsm::State StateIdle;
+hsm::State StateIdleStop(StateIdle);
+hsm::State StateIdleFF(StateIdle);
+hsm::State StateIdleRew(StateIdle);
+hsm::State StatePlaying;
+hsm::State StatePlayingPlay(StatePlaying);
+hsm::State StatePlayingPause(StatePlaying);
+hsm::State StateRecording;
+hsm::State StateRecordingRecord(StateRecording);
+hsm::State StateRecordingPause(StateRecording);
+
+static std::vector<hsm::Action> vcrTable()
+{
+	return {
+		{ StateOff,             Event::Entry,   print<EnterOff> },
+		{ StateOff,             Event::Exit,    print<ExitOff> },
+		{ StateOff,             Event::Power,   StateIdle },
+		{ StateIdle,            Event::Entry,   print<EnterIdle> },
+		{ StateIdle,            Event::Exit,    print<ExitIdle> },
+		{ StateIdle,            Event::Init,    StateIdleStop },
+		{ StateIdle,            Event::Power,   StateOff },
+		{ StateIdle,            Event::Play,    StatePlaying },
+		{ StateIdle,            Event::Rec,     StateRecording },
+		{ StateIdleStop,        Event::Entry,   print<EnterStop> },
+		{ StateIdleStop,        Event::Rew,     StateIdleRew },
+		{ StateIdleStop,        Event::FF,      StateIdleFF },
+		{ StateIdleRew,         Event::Entry,   print<EnterRew> },
+		{ StateIdleRew,         Event::Stop,    StateIdle },
+		{ StateIdleFF,          Event::Entry,   print<EnterFF> },
+		{ StateIdleFF,          Event::Stop,    StateIdle },
+		{ StatePlaying,         Event::Entry,   print<EnterPlaying> },
+		{ StatePlaying,         Event::Exit,    print<ExitPlaying> },
+		{ StatePlaying,         Event::Init,    StatePlayingPlay },
+		{ StatePlaying,         Event::Power,   StateOff },
+		{ StatePlaying,         Event::Stop,    StateIdle },
+		{ StatePlayingPlay,     Event::Entry,   print<EnterPlay> },
+		{ StatePlayingPlay,     Event::Pause,   StatePlayingPause },
+		{ StatePlayingPause,    Event::Entry,   print<EnterPause> },
+		{ StatePlayingPause,    Event::Play,    StatePlayingPlay },
+		{ StateRecording,       Event::Entry,   print<EnterRecording> },
+		{ StateRecording,       Event::Exit,    print<ExitRecording> },
+		{ StateRecording,       Event::Init,    StateRecordingRecord },
+		{ StateRecording,       Event::Power,   StateOff },
+		{ StateRecording,       Event::Stop,    StateIdle },
+		{ StateRecordingRecord, Event::Entry,   print<EnterRecord> },
+		{ StateRecordingRecord, Event::Pause,   StateRecordingPause },
+		{ StateRecordingPause,  Event::Entry,   print<EnterRecPause> },
+		{ StateRecordingPause,  Event::Rec,     StateRecordingRecord },
+	};
+}
+
+struct SOff             : hsm::StaticState<> {};
+struct SIdle            : hsm::StaticState<> {};
+struct SIdleStop        : hsm::StaticState<SIdle> {};
+struct SIdleFF          : hsm::StaticState<SIdle> {};
+struct SIdleRew         : hsm::StaticState<SIdle> {};
+struct SPlaying         : hsm::StaticState<> {};
+struct SPlayingPlay     : hsm::StaticState<SPlaying> {};
+struct SPlayingPause    : hsm::StaticState<SPlaying> {};
+struct SRecording       : hsm::StaticState<> {};
+struct SRecordingRecord : hsm::StaticState<SRecording> {};
+struct SRecordingPause  : hsm::StaticState<SRecording> {};
+
+using StaticVcr = hsm::StaticStateMachine
+<
+	hsm::StaticHandler   <SOff,             Event::Entry,   print<EnterOff>>,
+	hsm::StaticHandler   <SOff,             Event::Exit,    print<ExitOff>>,
+	hsm::StaticTransition<SOff,             Event::Power,   SIdle>,
+	hsm::StaticHandler   <SIdle,            Event::Entry,   print<EnterIdle>>,
+	hsm::StaticHandler   <SIdle,            Event::Exit,    print<ExitIdle>>,
+	hsm::StaticTransition<SIdle,            Event::Init,    SIdleStop>,
+	hsm::StaticTransition<SIdle,            Event::Power,   SOff>,
+	hsm::StaticTransition<SIdle,            Event::Play,    SPlaying>,
+	hsm::StaticTransition<SIdle,            Event::Rec,     SRecording>,
+	hsm::StaticHandler   <SIdleStop,        Event::Entry,   print<EnterStop>>,
+	hsm::StaticTransition<SIdleStop,        Event::Rew,     SIdleRew>,
+	hsm::StaticTransition<SIdleStop,        Event::FF,      SIdleFF>,
+	hsm::StaticHandler   <SIdleRew,         Event::Entry,   print<EnterRew>>,
+	hsm::StaticTransition<SIdleRew,         Event::Stop,    SIdle>,
+	hsm::StaticHandler   <SIdleFF,          Event::Entry,   print<EnterFF>>,
+	hsm::StaticTransition<SIdleFF,          Event::Stop,    SIdle>,
+	hsm::StaticHandler   <SPlaying,         Event::Entry,   print<EnterPlaying>>,
+	hsm::StaticHandler   <SPlaying,         Event::Exit,    print<ExitPlaying>>,
+	hsm::StaticTransition<SPlaying,         Event::Init,    SPlayingPlay>,
+	hsm::StaticTransition<SPlaying,         Event::Power,   SOff>,
+	hsm::StaticTransition<SPlaying,         Event::Stop,    SIdle>,
+	hsm::StaticHandler   <SPlayingPlay,     Event::Entry,   print<EnterPlay>>,
+	hsm::StaticTransition<SPlayingPlay,     Event::Pause,   SPlayingPause>,
+	hsm::StaticHandler   <SPlayingPause,    Event::Entry,   print<EnterPause>>,
+	hsm::StaticTransition<SPlayingPause,    Event::Play,    SPlayingPlay>,
+	hsm::StaticHandler   <SRecording,       Event::Entry,   print<EnterRecording>>,
+	hsm::StaticHandler   <SRecording,       Event::Exit,    print<ExitRecording>>,
+	hsm::StaticTransition<SRecording,       Event::Init,    SRecordingRecord>,
+	hsm::StaticTransition<SRecording,       Event::Power,   SOff>,
+	hsm::StaticTransition<SRecording,       Event::Stop,    SIdle>,
+	hsm::StaticHandler   <SRecordingRecord, Event::Entry,   print<EnterRecord>>,
+	hsm::StaticTransition<SRecordingRecord, Event::Pause,   SRecordingPause>,
+	hsm::StaticHandler   <SRecordingPause,  Event::Entry,   print<EnterRecPause>>,
+	hsm::StaticTransition<SRecordingPause,  Event::Rec,     SRecordingRecord>
+>;
+
+// the same VCR machine run by the dynamic, the enum and the static front end
+static void vcr()
+{
+	const std::vector<hsm::Action> tab_ = vcrTable();
+
+	out.clear();
+	hsm::Definition def_{tab_};
+	hsm::StateMachine hsm_{def_};
+	hsm_.start(StateOff);
+	for (unsigned event_: script)
+		hsm_.message({event_});
+	expect("vcr_dynamic", out, vcr_log);
+
+	out.clear();
+	hsm::StateMachine private_{tab_};
+	private_.start(StateOff);
+	for (unsigned event_: script)
+		private_.message({event_});
+	expect("vcr_private", out, vcr_log);
+
+	out.clear();
+	hsm::EnumDefinition<Event, Event::Last> enum_def_{tab_};
+	hsm::EnumStateMachine<Event, Event::Last> enum_{enum_def_};
+	enum_.start(StateOff);
+	for (unsigned event_: script)
+		enum_.message({event_});
+	expect("vcr_enum", out, vcr_log);
+
+	out.clear();
+	std::vector<hsm::Action> handled_;
+	for (const hsm::Action& action_: tab_)
+		if (&action_ == &tab_[2]) // StateOff, Event::Power, StateIdle
+			handled_.push_back({ StateOff, Event::Power, []( const hsm::Message& msg_ ) { hsm::EnumStateMachine<Event, Event::Last>::from(msg_).transition(StateIdle); } });
+		else
+			handled_.push_back(action_);
+	hsm::EnumDefinition<Event, Event::Last> handled_def_{std::move(handled_)};
+	hsm::EnumStateMachine<Event, Event::Last> handler_{handled_def_};
+	handler_.start(StateOff);
+	for (unsigned event_: script)
+		handler_.message({event_});
+	expect("vcr_enum_handler", out, vcr_log);
+
+	out.clear();
+	StaticVcr static_;
+	static_.start<SOff>();
+	for (unsigned event_: script)
+		static_.message({event_});
+	expect("vcr_static", out, vcr_log);
+
+	out.clear();
+	hsm::MessageQueue<4> queue_;
+	hsm::StateMachine queued_{def_};
+	queued_.attach(queue_);
+	queued_.start(StateOff);
+	for (unsigned event_: script)
+		queued_.message({event_});
+	expect("vcr_queued", out, vcr_log);
+}
+
+#if __cplusplus >= 202002L
+struct SA  : hsm::StaticState<> {};
+struct SB  : hsm::StaticState<> {};
+struct SB1 : hsm::StaticState<SB> {};
+struct SB2 : hsm::StaticState<SB> {};
+
+static constexpr char EnterA[]  = "[A";
+static constexpr char ExitA[]   = "A]";
+static constexpr char EnterB[]  = "[B";
+static constexpr char ExitB[]   = "B]";
+static constexpr char EnterB1[] = "[B1";
+static constexpr char EnterB2[] = "[B2";
+
+// event handlers taking the hsm object change the state as the handlers of hsm::StateMachine
+static void static_transition()
+{
+	const char expected_[] = "[A ping go A] [B [B2 pong [B1 B] [A A] ";
+	const unsigned script_[] = { Event::Ping, Event::Go, Event::Ping, Event::Back, hsm::Event::Stop };
+
+	hsm::StaticStateMachine
+	<
+		hsm::StaticHandler   <SA,  Event::Entry, print<EnterA>>,
+		hsm::StaticHandler   <SA,  Event::Exit,  print<ExitA>>,
+		hsm::StaticHandler   <SA,  Event::Ping,  []( auto& hsm_, const hsm::Message& ){ mark("ping"); hsm_.template transition<SA>(); }>,
+		hsm::StaticHandler   <SA,  Event::Go,    []( auto& hsm_, const hsm::Message& ){ mark("go"); hsm_.template transition<SB>(); }>,
+		hsm::StaticHandler   <SB,  Event::Entry, print<EnterB>>,
+		hsm::StaticHandler   <SB,  Event::Exit,  print<ExitB>>,
+		hsm::StaticHandler   <SB,  Event::Init,  []( auto& hsm_, const hsm::Message& ){ hsm_.template transition<SB2>(); }>,
+		hsm::StaticTransition<SB,  Event::Back,  SA>,
+		hsm::StaticHandler   <SB1, Event::Entry, print<EnterB1>>,
+		hsm::StaticHandler   <SB2, Event::Entry, print<EnterB2>>,
+		hsm::StaticHandler   <SB2, Event::Ping,  []( auto& hsm_, const hsm::Message& ){ mark("pong"); hsm_.template transition<SB1>(); }>
+	> static_;
+
+	out.clear();
+	static_.start<SA>();
+	for (unsigned event_: script_)
+		static_.message({event_});
+	expect("static_transition", out, expected_);
+
+	hsm::State a_, b_, b1_{b_}, b2_{b_};
+	hsm::StateMachine hsm_{{
+		{ a_,  Event::Entry, print<EnterA> },
+		{ a_,  Event::Exit,  print<ExitA> },
+		{ a_,  Event::Ping,  [&a_]( const hsm::Message& m ){ mark("ping"); m.hsm->transition(a_); } },
+		{ a_,  Event::Go,    [&b_]( const hsm::Message& m ){ mark("go"); m.hsm->transition(b_); } },
+		{ b_,  Event::Entry, print<EnterB> },
+		{ b_,  Event::Exit,  print<ExitB> },
+		{ b_,  Event::Init,  [&b2_]( const hsm::Message& m ){ m.hsm->transition(b2_); } },
+		{ b_,  Event::Back,  a_ },
+		{ b1_, Event::Entry, print<EnterB1> },
+		{ b2_, Event::Entry, print<EnterB2> },
+		{ b2_, Event::Ping,  [&b1_]( const hsm::Message& m ){ mark("pong"); m.hsm->transition(b1_); } },
+	}};
+
+	out.clear();
+	hsm_.start(a_);
+	for (unsigned event_: script_)
+		hsm_.message({event_});
+	expect("dynamic_transition", out, expected_);
+}
+#endif
+
+// two orthogonal regions, one of them with the nested parallel state
+static void regions()
+{
+	hsm::State off_, on_{hsm::State::Parallel};
+	hsm::State caps_{on_}, caps_off_{caps_}, caps_on_{caps_};
+	hsm::State num_{on_}, num_off_{num_}, num_on_{num_, hsm::State::Parallel};
+	hsm::State a_{num_on_}, b_{num_on_};
+
+	hsm::Definition def_{{
+		{ off_,     Event::Power, on_ },
+		{ on_,      Event::Entry, []( const hsm::Message& ){ mark("[On"); } },
+		{ on_,      Event::Exit,  []( const hsm::Message& ){ mark("On]"); } },
+		{ on_,      Event::Stop,  off_ },
+		{ caps_,    Event::Entry, []( const hsm::Message& ){ mark("[C"); } },
+		{ caps_,    Event::Exit,  []( const hsm::Message& ){ mark("C]"); } },
+		{ caps_,    Event::Init,  caps_off_ },
+		{ caps_off_,Event::Entry, []( const hsm::Message& ){ mark("[c0"); } },
+		{ caps_off_,Event::Exit,  []( const hsm::Message& ){ mark("c0]"); } },
+		{ caps_off_,Event::Rec,   caps_on_ },
+		{ caps_on_, Event::Entry, []( const hsm::Message& ){ mark("[c1"); } },
+		{ caps_on_, Event::Exit,  []( const hsm::Message& ){ mark("c1]"); } },
+		{ caps_on_, Event::Rec,   caps_off_ },
+		{ caps_on_, Event::Go,    num_on_ },
+		{ num_,     Event::Entry, []( const hsm::Message& ){ mark("[N"); } },
+		{ num_,     Event::Exit,  []( const hsm::Message& ){ mark("N]"); } },
+		{ num_,     Event::Init,  num_off_ },
+		{ num_off_, Event::Entry, []( const hsm::Message& ){ mark("[n0"); } },
+		{ num_off_, Event::Exit,  []( const hsm::Message& ){ mark("n0]"); } },
+		{ num_off_, Event::Play,  num_on_ },
+		{ num_on_,  Event::Entry, []( const hsm::Message& ){ mark("[n1"); } },
+		{ num_on_,  Event::Exit,  []( const hsm::Message& ){ mark("n1]"); } },
+		{ num_on_,  Event::Play,  num_off_ },
+		{ a_,       Event::Entry, []( const hsm::Message& ){ mark("[a"); } },
+		{ a_,       Event::Exit,  []( const hsm::Message& ){ mark("a]"); } },
+		{ a_,       Event::Ping,  []( const hsm::Message& ){ mark("A"); } },
+		{ b_,       Event::Entry, []( const hsm::Message& ){ mark("[b"); } },
+		{ b_,       Event::Exit,  []( const hsm::Message& ){ mark("b]"); } },
+		{ b_,       Event::Ping,  []( const hsm::Message& ){ mark("B"); } },
+		{ b_,       Event::Back,  off_ },
+		{ caps_,    Event::Ping,  []( const hsm::Message& ){ mark("C"); } },
+		{ num_,     Event::Ping,  []( const hsm::Message& ){ mark("N"); } },
+	}};
+
+	hsm::StateMachine hsm_{def_};
+	auto step_ = [&]( unsigned event_ ){ hsm_.message({event_}); mark("|"); };
+
+	out.clear();
+	hsm_.start(off_);
+	step_(Event::Power); step_(Event::Rec); step_(Event::Play); step_(Event::Ping); step_(Event::Play);
+	step_(Event::Go); step_(Event::Ping); step_(Event::Back); step_(Event::Power); step_(Event::Stop);
+	expect("regions", out,
+		"[On [C [c0 [N [n0 | c0] [c1 | n0] [n1 [a [b | C A B | b] a] n1] [n0 | "
+		"c1] C] n0] N] [C [c0 [N [n1 [a [b | C A B | b] a] n1] N] c0] C] On] | "
+		"[On [C [c0 [N [n0 | n0] N] c0] C] On] | ");
+
+	unsigned snapshot_[8] = {};
+	hsm_.message({hsm::Event::Stop});
+	hsm_.start(off_);
+	hsm_.message({Event::Power});
+	hsm_.message({Event::Rec});
+	const std::size_t size_ = hsm_.save(snapshot_);
+	hsm::StateMachine copy_{def_};
+	copy_.restore(snapshot_);
+	out.clear();
+	copy_.message({Event::Ping});
+	copy_.message({Event::Stop});
+	expect("regions_restore", out + std::to_string(size_), "C N n0] N] c1] C] On] 5");
+}
+
+// shallow and deep history of the composite state
+template<hsm::State::Kind K>
+static void history( const char *name_, const char *expected_ )
+{
+	hsm::State off_, h_{K}, a_{h_}, b_{h_}, b1_{b_}, b2_{b_};
+
+	hsm::Definition def_{{
+		{ off_, Event::Go,    h_ },
+		{ h_,   Event::Entry, []( const hsm::Message& ){ mark("[H"); } },
+		{ h_,   Event::Exit,  []( const hsm::Message& ){ mark("H]"); } },
+		{ h_,   Event::Init,  a_ },
+		{ h_,   Event::Back,  off_ },
+		{ a_,   Event::Entry, []( const hsm::Message& ){ mark("[A"); } },
+		{ a_,   Event::Exit,  []( const hsm::Message& ){ mark("A]"); } },
+		{ a_,   Event::Play,  b_ },
+		{ b_,   Event::Entry, []( const hsm::Message& ){ mark("[B"); } },
+		{ b_,   Event::Exit,  []( const hsm::Message& ){ mark("B]"); } },
+		{ b_,   Event::Init,  b1_ },
+		{ b1_,  Event::Entry, []( const hsm::Message& ){ mark("[B1"); } },
+		{ b1_,  Event::Exit,  []( const hsm::Message& ){ mark("B1]"); } },
+		{ b1_,  Event::Play,  b2_ },
+		{ b2_,  Event::Entry, []( const hsm::Message& ){ mark("[B2"); } },
+		{ b2_,  Event::Exit,  []( const hsm::Message& ){ mark("B2]"); } },
+	}};
+
+	hsm::StateMachine hsm_{def_};
+	auto step_ = [&]( unsigned event_ ){ hsm_.message({event_}); mark("|"); };
+
+	out.clear();
+	hsm_.start(off_);
+	step_(Event::Go); step_(Event::Play); step_(Event::Play); step_(Event::Back); step_(Event::Go);
+
+	unsigned snapshot_[4] = {};
+	hsm_.message({Event::Back});
+	hsm_.save(snapshot_);
+	hsm::StateMachine copy_{def_};
+	copy_.restore(snapshot_);
+	copy_.message({Event::Go});
+	expect(name_, out, expected_);
+}
+
+#ifndef HSM_PAYLOAD
+static_assert(sizeof(hsm::Message) <= 2 * sizeof(void *), "the plain message is two words");
+#endif
+
+// the handled Play message, with its payload if available
+#ifdef HSM_PAYLOAD
+static std::string played( const hsm::Message& m ) { return "play" + std::to_string(*m.get<int>()); }
+#else
+static std::string played( const hsm::Message& ) { return "play"; }
+#endif
+
+// events deferred by the busy state are replayed in order after each transition
+static void deferral()
+{
+	hsm::State top_, idle_{top_}, busy_{top_}, sub_{busy_};
+
+	hsm::Definition def_{{
+		{ top_,  Event::Init,  idle_ },
+		{ idle_, Event::Entry, []( const hsm::Message& ){ mark("I"); } },
+		{ busy_, Event::Entry, []( const hsm::Message& ){ mark("B"); } },
+		{ idle_, Event::Play,  [&busy_]( const hsm::Message& m ){ mark(played(m).c_str()); m.hsm->transition(busy_); } },
+		{ idle_, Event::Rew,   []( const hsm::Message& ){ mark("rew"); } },
+		{ busy_, Event::Play,  hsm::Defer{} },
+		{ busy_, Event::Rew,   hsm::Defer{} },
+		{ sub_,  Event::Rew,   []( const hsm::Message& ){ mark("subrew"); } },
+		{ busy_, Event::Stop,  idle_ },
+	}};
+
+#ifdef HSM_PAYLOAD
+	static const int a_ = 1, b_ = 2, c_ = 3;
+	const hsm::Message play_[] = { {Event::Play, a_}, {Event::Play, b_}, {Event::Play, c_} };
+	const char expected_[] = "I play1 B | I play2 B | I rew play3 B | I 0";
+#else
+	const hsm::Message play_[] = { {Event::Play}, {Event::Play}, {Event::Play} };
+	const char expected_[] = "I play B | I play B | I rew play B | I 0";
+#endif
+
+	hsm::MessageQueue<4> deferred_;
+	hsm::StateMachine hsm_{def_};
+	hsm_.defer(deferred_);
+
+	out.clear();
+	hsm_.start(top_);
+	hsm_.message(play_[0]);
+	hsm_.message(play_[1]);
+	hsm_.message({Event::Rew});
+	hsm_.message(play_[2]);
+	mark("|");
+	hsm_.message({Event::Stop});
+	mark("|");
+	hsm_.message({Event::Stop});
+	mark("|");
+	hsm_.message({Event::Stop});
+	expect("deferral", out + std::to_string(deferred_.size()), expected_);
+}
+
+// state timeouts armed on entry and disarmed on exit, also for moved and restored machines
+static void timers()
+{
+	hsm::State top_, wait_{top_}, retry_{top_}, done_{top_};
+
+	hsm::Definition def_{{
+		{ top_,   Event::Init,  wait_ },
+		{ wait_,  Event::Go,    hsm::Timeout{200} },
+		{ wait_,  Event::Go,    retry_ },
+		{ wait_,  Event::Back,  done_ },
+		{ retry_, Event::Ping,  hsm::Timeout{50} },
+		{ retry_, Event::Ping,  wait_ },
+		{ retry_, Event::Entry, []( const hsm::Message& ){ out += 'R'; } },
+		{ done_,  Event::Play,  wait_ },
+		{ top_,   Event::Pause, hsm::Timeout{1000} },
+		{ top_,   Event::Pause, []( const hsm::Message& ){ out += 'I'; } },
+	}};
+
+	hsm::TimerWheel wheel_{64};
+	std::vector<hsm::StateMachine> hsm_;
+	for (int i = 0; i < 6; i++)
+	{
+		hsm_.emplace_back(def_);
+		hsm_.back().attach(wheel_);
+		hsm_.back().start(top_);
+	}
+
+	out.clear();
+	out += std::to_string(wheel_.size()) + " ";
+	hsm_[0].message({Event::Back});
+	out += std::to_string(wheel_.size()) + " ";
+	wheel_.advance(200);
+	out += " " + std::to_string(wheel_.size()) + " ";
+	wheel_.advance(800);
+	out += " " + std::to_string(wheel_.size()) + " ";
+	hsm_[1].message({hsm::Event::Stop});
+	out += std::to_string(wheel_.size()) + " ";
+	unsigned state_ = hsm_[2].save();
+	hsm_[2].message({hsm::Event::Stop});
+	hsm_[2].restore(state_);
+	out += std::to_string(wheel_.size()) + " ";
+	hsm_.clear();
+	out += std::to_string(wheel_.size());
+	expect("timers", out, "12 11 RRRRR 11 RRRRRRRRRRRRRRRIIIIII 5 4 5 0");
+}
+
+// the hsm running the live definition switches to the patched revision between messages
+static void live()
+{
+	hsm::State a_, b_, c_{a_}, d_{a_};
+
+	hsm::LiveDefinition live_{{
+		{ a_, Event::Init,  c_ },
+		{ c_, Event::Go,    d_ },
+		{ d_, Event::Ping,  []( const hsm::Message& ){ mark("ping1"); } },
+		{ d_, Event::Back,  c_ },
+		{ a_, Event::Entry, []( const hsm::Message& ){ mark("eA"); } },
+	}};
+
+	hsm::MessageQueue<8> queue_;
+	hsm::StateMachine hsm_{live_};
+	hsm_.attach(queue_);
+
+	out.clear();
+	hsm_.start(a_);
+	hsm_.message({Event::Go});
+	hsm_.message({Event::Ping});
+	unsigned version_ = live_.patch({
+		{ d_, Event::Ping,  []( const hsm::Message& ){ mark("ping2"); } },
+		{ b_, Event::Entry, []( const hsm::Message& ){ mark("eB"); } },
+		{ d_, Event::Go,    b_ },
+	});
+	out += "v" + std::to_string(version_) + " r" + std::to_string(live_.reclaim()) + " ";
+	hsm_.message({Event::Ping});
+	out += "r" + std::to_string(live_.reclaim()) + " ";
+	hsm_.message({Event::Go});
+	hsm_.message({hsm::Event::Stop});
+	expect("live", out, "eA ping1 v2 r1 ping2 r0 eB ");
+}
+
+#if defined(__cpp_impl_coroutine)
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wzero-as-null-pointer-constant" // false positive on the generated coroutine frame
+#endif
+// the coroutine handler suspends the handling of the message, incoming messages are queued
+static void coroutine()
+{
+	static std::vector<std::coroutine_handle<>> ready_;
+	struct Later { bool await_ready() { return false; } void await_suspend( std::coroutine_handle<> h ) { ready_.push_back(h); } int await_resume() { return 7; } };
+	struct Now { bool await_ready() { return false; } bool await_suspend( std::coroutine_handle<> ) { return false; } void await_resume() {} };
+
+	hsm::State a_, b_, c_;
+	hsm::MessageQueue<8> queue_;
+
+	hsm::StateMachine hsm_{{
+		{ a_, Event::Entry, []( const hsm::Message& ){ mark("eA"); } },
+		{ a_, Event::Exit,  []( const hsm::Message& ){ mark("xA"); } },
+		{ b_, Event::Entry, []( const hsm::Message& ){ mark("eB"); } },
+		{ c_, Event::Entry, []( const hsm::Message& ){ mark("eC"); } },
+		{ a_, Event::Go,    [&b_]( hsm::Message m ) -> hsm::Task { mark("go"); int v = co_await Later{}; out += "v" + std::to_string(v) + " "; m.hsm->transition(b_); } },
+		{ a_, Event::Ping,  []( const hsm::Message& ){ mark("pingA"); } },
+		{ b_, Event::Ping,  []( const hsm::Message& ){ mark("pingB"); } },
+		{ b_, Event::Play,  [&c_]( hsm::Message m ) -> hsm::Task { co_await Now{}; mark("fast"); m.hsm->transition(c_); } },
+	}};
+	hsm_.attach(queue_);
+
+	out.clear();
+	hsm_.start(a_);
+	hsm_.message({Event::Go});
+	hsm_.message({Event::Ping});
+	hsm_.message({Event::Ping});
+	mark("|");
+	auto handle_ = ready_.back();
+	ready_.pop_back();
+	handle_.resume();
+	mark("|");
+	hsm_.message({Event::Play});
+	hsm_.message({Event::Ping});
+	expect("coroutine", out + std::to_string(queue_.size()), "eA go | v7 xA eB pingB pingB | fast eC 0");
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+// the inbox stops pumping while the hsm is suspended and releases the node after the message is handled
+static void inbox()
+{
+	static hsm::StateMachine::Suspension suspension_;
+	hsm::State top_, idle_{top_}, busy_{top_};
+
+	hsm::Definition def_{{
+		{ top_,  Event::Init,  idle_ },
+		{ idle_, Event::Entry, []( const hsm::Message& ){ mark("I"); } },
+		{ busy_, Event::Entry, []( const hsm::Message& ){ mark("B"); } },
+		{ idle_, Event::Play,  [&busy_]( const hsm::Message& m ){ mark("play"); m.hsm->transition(busy_); m.hsm->suspend(suspension_); } },
+		{ busy_, Event::Stop,  idle_ },
+	}};
+
+	hsm::MessageQueue<4> queue_;
+	hsm::StateMachine hsm_{def_};
+	hsm::UnboundedInbox inbox_{hsm_};
+	hsm_.attach(queue_);
+
+	auto released_ = []( hsm::InboxNode *node_ ){ out += "~" + std::to_string(node_->message.event - Event::Power) + " "; };
+	hsm::InboxNode node_[] = { {{Event::Play}, released_}, {{Event::Stop}, released_}, {{Event::Play}, released_} };
+
+	out.clear();
+	hsm_.start(top_);
+	for (auto& item_: node_)
+		inbox_.post(item_);
+	mark(inbox_.pump() ? "more" : "done");
+	mark(inbox_.pump() ? "more" : "done");
+	hsm_.resume();
+	mark(inbox_.pump() ? "more" : "done");
+	hsm_.resume();
+	mark(inbox_.pump() ? "more" : "done");
+	expect("inbox", out + std::to_string(inbox_.dropped()), "I play more more B ~2 I ~1 play done B ~2 done 0");
+}
+
+// the compiled definition saved as the binary image and loaded in place runs the same way
+static void image()
+{
+	hsm::Handler off_entry_ = print<EnterOff>;
+	hsm::Handler idle_entry_ = print<EnterIdle>;
+	hsm::Handler stop_entry_ = print<EnterStop>;
+	hsm::Handler play_entry_ = print<EnterPlay>;
+
+	hsm::Definition def_{{
+		{ StateOff,      Event::Entry, off_entry_ },
+		{ StateOff,      Event::Power, StateIdle },
+		{ StateIdle,     Event::Entry, idle_entry_ },
+		{ StateIdle,     Event::Init,  StateIdleStop },
+		{ StateIdle,     Event::Power, StateOff },
+		{ StateIdle,     Event::Play,  StatePlaying },
+		{ StateIdleStop, Event::Entry, stop_entry_ },
+		{ StatePlaying,  Event::Entry, play_entry_ },
+		{ StatePlaying,  Event::Stop,  StateIdle },
+		{ StatePlaying,  Event::Power, StateOff },
+	}};
+
+	std::FILE *file_ = std::tmpfile();
+	if (file_ == nullptr || !def_.save(file_))
+		return expect("image", "no image", "");
+	std::vector<std::uint64_t> data_(static_cast<std::size_t>(std::ftell(file_) + 7) / 8);
+	std::rewind(file_);
+	std::size_t size_ = std::fread(data_.data(), 1, data_.size() * 8, file_);
+	std::fclose(file_);
+
+	hsm::State *states_[] = { &StateOff, &StateIdle, &StateIdleStop, &StatePlaying };
+	hsm::State *bound_[4] = {};
+	for (hsm::State *state_: states_)
+		bound_[def_.id(*state_)] = state_;
+	const hsm::Handler *slots_[] = { &off_entry_, &idle_entry_, &stop_entry_, &play_entry_ };
+
+	hsm::Definition loaded_;
+	hsm::Definition broken_;
+	bool valid_ = loaded_.load(data_.data(), size_, slots_, 4, bound_, 4) && !broken_.load(data_.data(), size_ - 1, slots_, 4, bound_, 4);
+
+	std::string result_[2];
+	const hsm::Definition *defs_[] = { &def_, &loaded_ };
+	for (int i = 0; valid_ && i < 2; i++)
+	{
+		out.clear();
+		hsm::StateMachine hsm_{*defs_[i]};
+		hsm_.start(StateOff);
+		for (unsigned event_: { Power, Play, Stop, Play, Power, Power, Stop })
+			hsm_.message({event_});
+		result_[i] = out;
+	}
+
+	expect("image", valid_ && result_[0] == result_[1] ? result_[1] : "invalid", "[Off [Idle [Stop [Play [Idle [Stop [Play [Off [Idle [Stop ");
+}
+
+// instances of the array follow the same states as separate hsm objects
+static void array()
+{
+	const std::vector<hsm::Action> tab_ = vcrTable();
+	hsm::Definition def_{tab_};
+	const std::size_t count_ = 16;
+
+	hsm::StateMachineArray array_{def_, count_};
+	std::deque<hsm::StateMachine> hsm_;
+	array_.start(StateOff);
+	for (std::size_t i = 0; i < count_; i++)
+		hsm_.emplace_back(def_).start(StateOff);
+
+	std::vector<hsm::Message> batch_(count_);
+	std::string states_, expected_;
+	out.clear();
+	for (std::size_t step_ = 0; step_ < 64; step_++)
+	{
+		for (std::size_t i = 0; i < count_; i++)
+			batch_[i] = { script[(step_ + i) % (sizeof(script) / sizeof(*script) - 1)] };
+		if (step_ % 2)
+			array_.message(batch_.data());
+		else
+			for (std::size_t i = 0; i < count_; i++)
+				array_.message(i, batch_[i]);
+		for (std::size_t i = 0; i < count_; i++)
+			hsm_[i].message(batch_[i]);
+	}
+
+	for (std::size_t i = 0; i < count_; i++)
+	{
+		states_ += std::to_string(array_.save(i)) + " ";
+		expected_ += std::to_string(hsm_[i].save()) + " ";
+	}
+	expect("array", states_, expected_.c_str());
+}
+
+#ifdef HSM_TRACE
+// the traced build records the handled event, the transition and every handler on the way
+static void trace()
+{
+	const std::vector<hsm::Action> tab_ = vcrTable();
+	hsm::Definition def_{tab_};
+	hsm::StateMachine hsm_{def_};
+	hsm_.start(StateOff);
+
+	static const char kinds_[] = "AUTXNI";
+	hsm::Trace::clear();
+	hsm_.message({Event::Power});
+	hsm_.message({Event::Pause});
+	out.clear();
+	hsm::Trace::collect([]( const hsm::TraceRecord& record_ ){ out += kinds_[record_.kind]; });
+	expect("trace", out, "ATXNITNU");
+
+	// the collapsed chain of pure Init transitions is recorded as the chain of single transitions
+	hsm::State top_, a_{top_}, b_{a_}, c_{b_}, d_{c_};
+	hsm::Definition chain_{{
+		{ top_, Event::Init,  a_ },
+		{ a_,   Event::Init,  c_ },
+		{ c_,   Event::Init,  d_ },
+		{ b_,   Event::Entry, print<EnterIdle> },
+	}};
+	hsm::StateMachine collapsed_{chain_};
+	hsm::Trace::clear();
+	collapsed_.start(top_);
+	out.clear();
+	hsm::Trace::collect([]( const hsm::TraceRecord& record_ ){ out += kinds_[record_.kind]; out += std::to_string(record_.data) + " "; });
+	expect("trace_chain", out, "T0 I0 T1 I1 T3 N3 I2 T4 ");
+}
+
+// pure transitions resolved by the jump table of the array are recorded as if handled by the hsm object
+static void trace_array()
+{
+	hsm::State top_, a_{top_}, a1_{a_}, a2_{a_}, b_{top_}, b1_{b_}, b11_{b1_};
+	hsm::Definition def_{{
+		{ top_, Event::Init, a_   },
+		{ a_,   Event::Init, a1_  },
+		{ a1_,  Event::Go,   a2_  },
+		{ a2_,  Event::Go,   b_   },
+		{ a_,   Event::Ping       },
+		{ b_,   Event::Init, b1_  },
+		{ b1_,  Event::Init, b11_ },
+		{ b_,   Event::Back, a_   },
+	}};
+	static const unsigned script_[] = { Event::Go, Event::Ping, Event::Go, Event::Rew, Event::Back, Event::Go };
+	const std::size_t count_ = 16;
+
+	hsm::Metrics metrics_[2];
+	hsm::StateMachineArray array_{def_, count_};
+	std::deque<hsm::StateMachine> hsm_;
+	array_.start(top_);
+	array_.attach(metrics_[0]);
+	for (std::size_t i = 0; i < count_; i++)
+	{
+		hsm_.emplace_back(def_).start(top_);
+		hsm_.back().attach(metrics_[1]);
+	}
+
+	auto collect_ = []( std::string& result_ )
+	{
+		hsm::Trace::collect([&result_]( const hsm::TraceRecord& record_ ){
+			result_ += std::to_string(record_.kind) + ":" + std::to_string(record_.state) + ":" + std::to_string(record_.event) + ":" + std::to_string(record_.data) + " "; });
+	};
+
+	std::vector<hsm::Message> batch_(count_);
+	std::string result_[2];
+	for (std::size_t step_ = 0; step_ < 24; step_++)
+	{
+		for (std::size_t i = 0; i < count_; i++)
+			batch_[i] = { script_[(step_ + i) % (sizeof(script_) / sizeof(*script_))] };
+		hsm::Trace::clear();
+		array_.message(batch_.data());
+		collect_(result_[0]);
+		hsm::Trace::clear();
+		for (std::size_t i = 0; i < count_; i++)
+			hsm_[i].message(batch_[i]);
+		collect_(result_[1]);
+	}
+	expect("trace_array", result_[0], result_[1].c_str());
+
+	const hsm::Metrics::Snapshot snapshot_[2] = { array_.snapshot(), hsm_.front().snapshot() };
+	for (std::size_t k = 0; k < 2; k++)
+	{
+		out.clear();
+		for (const auto& state_: snapshot_[k].states)
+			mark((std::to_string(state_.entries) + "/" + std::to_string(state_.exits)).c_str());
+		for (const auto& cell_: snapshot_[k].cells)
+			mark((std::to_string(cell_.hits) + "/" + std::to_string(cell_.walked) + "/" + std::to_string(cell_.unhandled)).c_str());
+		result_[k] = out;
+	}
+	expect("metrics_array", result_[0], result_[1].c_str());
+}
+#endif
+
+/* -------------------------------------------------------------------------- */
+
+int main()
+{
+	vcr();
+#if __cplusplus >= 202002L
+	static_transition();
+#endif
+	regions();
+	history<hsm::State::Exclusive>("history_none", "[H [A | A] [B [B1 | B1] [B2 | B2] B] H] | [H [A | A] H] [H [A ");
+	history<hsm::State::Shallow>("history_shallow", "[H [A | A] [B [B1 | B1] [B2 | B2] B] H] | [H [B [B1 | B1] B] H] [H [B [B1 ");
+	history<hsm::State::Deep>("history_deep", "[H [A | A] [B [B1 | B1] [B2 | B2] B] H] | [H [B [B2 | B2] B] H] [H [B [B2 ");
+	deferral();
+	timers();
+	live();
+#if defined(__cpp_impl_coroutine)
+	coroutine();
+#endif
+	inbox();
+	image();
+	array();
+#ifdef HSM_TRACE
+	trace();
+	trace_array();
+#endif
+
+	std::printf("%u failed\n", failed);
+	return static_cast<int>(failed);
+}
@@ -0,0 +1,4 @@
+#define HSM_TRACE   1024
+#define HSM_METRICS
+#define HSM_PAYLOAD
+#include "check.cpp"
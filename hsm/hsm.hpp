@@ -2,7 +2,7 @@
 
     @file    hsm.hpp
     @author  Rajmund Szymanski
-    @date    09.08.2022
+    @date    14.10.2026
     @brief   This file contains definitions for hierachical state machine.
 
  ******************************************************************************
@@ -36,13 +36,49 @@
 #warning required c++ 17 or above!
 #endif
 
+#include <algorithm>
+#include <atomic>
+#ifndef HSM_FREESTANDING
 #include <functional>
+#endif
+#include <initializer_list>
 #include <iterator>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
 #include <variant>
 #include <vector>
+#if __cplusplus >= 202002L
+#include <span>
+#endif
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include "hsm.hpp"
 #include "hsmconfig.hpp"
+#include "hsmtimer.hpp"
+
+#if !defined(HSM_AVX2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(HSM_FREESTANDING)
+#define HSM_AVX2 1 // AVX2 gathers are selected at run time
+#endif
+#if defined(HSM_AVX2) && HSM_AVX2
+#include <immintrin.h>
+#endif
+
+#ifdef HSM_TRACE
+#include "hsmtrace.hpp"
+#define HSM_TRACE_RECORD( kind, state, event, data ) hsm::Trace::record(hsm::TraceKind::kind, this, state, event, data)
+#else
+#define HSM_TRACE_RECORD( kind, state, event, data ) static_cast<void>(0)
+#endif
+
+#ifdef HSM_METRICS
+#include "hsmmetrics.hpp"
+#endif
 
 namespace hsm {
 
@@ -64,7 +100,110 @@ enum Event : unsigned
 
 struct State;        // forward declarations
 struct Action;       // *
+struct Definition;   // *
 struct StateMachine; // *
+struct StateMachineArray; // *
+struct LiveDefinition; // *
+struct Profile; // *
+struct Inbox; // *
+template<class E, std::size_t N>
+struct EnumDefinition; // *
+
+/******************************************************************************
+ *
+ * Class             : InplaceHandler
+ *
+ * Description       : hsm event handler with fixed-capacity internal storage
+ *                     never allocates memory; the callable object is stored
+ *                     inside the handler and must fit into its capacity
+ *
+ * Constructor parameters
+ *          function : callable object or pointer to function
+ *                     invocable with the message (const Message&)
+ *                or
+ *          function : pointer to function taking context and message
+ *           context : context pointer passed to the function
+ *
+ ******************************************************************************/
+
+template<std::size_t N>
+struct InplaceHandler
+{
+	InplaceHandler() {}
+
+	template<class F, class D = std::decay_t<F>, std::enable_if_t<!std::is_same_v<D, InplaceHandler> && std::is_invocable_r_v<void, D&, const Message&>, int> = 0>
+	InplaceHandler( F&& function_ )
+	{
+		static_assert(sizeof(D) <= N, "callable object exceeds the handler capacity");
+		static_assert(alignof(D) <= alignof(std::max_align_t), "unsupported callable object alignment");
+
+		::new (InplaceHandler::data) D(std::forward<F>(function_));
+		InplaceHandler::invoke = &InplaceHandler::invokeFunction<D>;
+		InplaceHandler::manage = &InplaceHandler::manageFunction<D>;
+	}
+
+	InplaceHandler( void (*function_)( void *, const Message& ), void *context_ ):
+		InplaceHandler([function_, context_]( const Message& message_ ){ function_(context_, message_); }) {}
+
+	InplaceHandler( InplaceHandler&& handler_ ) noexcept: InplaceHandler() { InplaceHandler::assign(handler_, Operation::Move); }
+	InplaceHandler( const InplaceHandler& handler_ ): InplaceHandler() { InplaceHandler::assign(handler_, Operation::Copy); }
+
+	InplaceHandler& operator=( InplaceHandler&& handler_ ) noexcept { if (this != &handler_) { InplaceHandler::reset(); InplaceHandler::assign(handler_, Operation::Move); } return *this; }
+	InplaceHandler& operator=( const InplaceHandler& handler_ ) { if (this != &handler_) { InplaceHandler::reset(); InplaceHandler::assign(handler_, Operation::Copy); } return *this; }
+
+	~InplaceHandler() { InplaceHandler::reset(); }
+
+	void operator()( const Message& message_ ) const { assert(InplaceHandler::invoke != nullptr); InplaceHandler::invoke(InplaceHandler::data, message_); }
+
+	explicit operator bool() const { return InplaceHandler::invoke != nullptr; }
+
+/* -------------------------------------------------------------------------- */
+
+	private:
+	enum class Operation { Copy, Move, Destroy };
+
+	alignas(std::max_align_t)
+	mutable unsigned char data[N];                                    // storage of the callable object
+	void (*invoke)( void *, const Message& ){};                       // callable object invoker
+	void (*manage)( void *, const void *, Operation ){};              // callable object manager
+
+	template<class D>
+	static void invokeFunction( void *data_, const Message& message_ )
+	{
+		(*static_cast<D *>(data_))(message_);
+	}
+
+	template<class D>
+	static void manageFunction( void *data_, const void *source_, Operation operation_ )
+	{
+		switch (operation_)
+		{
+		case Operation::Copy:    ::new (data_) D(*static_cast<const D *>(source_)); break;
+		case Operation::Move:    ::new (data_) D(std::move(*static_cast<D *>(const_cast<void *>(source_)))); break;
+		case Operation::Destroy: static_cast<D *>(data_)->~D(); break;
+		}
+	}
+
+	void assign( const InplaceHandler& handler_, Operation operation_ )
+	{
+		if (handler_.invoke != nullptr)
+		{
+			handler_.manage(InplaceHandler::data, handler_.data, operation_);
+			InplaceHandler::invoke = handler_.invoke;
+			InplaceHandler::manage = handler_.manage;
+		}
+	}
+
+	void reset()
+	{
+		if (InplaceHandler::invoke != nullptr)
+		{
+			InplaceHandler::manage(InplaceHandler::data, nullptr, Operation::Destroy);
+			InplaceHandler::invoke = nullptr;
+			InplaceHandler::manage = nullptr;
+		}
+	}
+};
 
 /******************************************************************************
  *
@@ -84,7 +223,50 @@ struct StateMachine; // *
  *
  ******************************************************************************/
 
+#if defined HSM_FREESTANDING
+using Handler = void (*)( const Message& );
+#elif defined HSM_HANDLER_SIZE
+using Handler = InplaceHandler<HSM_HANDLER_SIZE>;
+#else
 using Handler = std::function<void ( const Message& )>;
+#endif
+
+/******************************************************************************
+ *
+ * Type              : Guard
+ *
+ * Description       : hsm transition guard
+ *                     predicate over the received message, evaluated by the dispatcher
+ *                     before the guarded direct transition; must not change the hsm
+ *
+ ******************************************************************************/
+
+using Guard = bool (*)( const Message& );
+
+/******************************************************************************
+ *
+ * Type              : Defer
+ *
+ * Description       : tag of the hsm action deferring the user event
+ *                     the deferred message is kept in the deferral queue of the hsm instance
+ *                     and replayed after the next transition
+ *
+ ******************************************************************************/
+
+struct Defer {};
+
+/******************************************************************************
+ *
+ * Type              : Timeout
+ *
+ * Description       : hsm state timeout: delay in ticks of the timer wheel
+ *                     the timer is armed on entry to the owner state and disarmed on exit;
+ *                     the expired timer sends the user event to the hsm instance
+ *                     the delay must be less than 65535 with HSM_SMALL_INDEX defined
+ *
+ ******************************************************************************/
+
+struct Timeout { unsigned delay; };
 
 /******************************************************************************
  *
@@ -94,446 +276,4231 @@ using Handler = std::function<void ( const Message& )>;
  *
  ******************************************************************************/
 
-using Variant = std::variant<State*, Handler>;
+using Variant = std::variant<State*, Handler>;
+
+/******************************************************************************
+ *
+ * Type              : Table
+ *
+ * Description       : set of hsm actions
+ *                     std::initializer_list in the freestanding profile (the actions are copied)
+ *
+ ******************************************************************************/
+
+#ifdef HSM_FREESTANDING
+using Table = std::initializer_list<Action>;
+#else
+using Table = std::vector<Action>;
+#endif
+
+/******************************************************************************
+ *
+ * Class             : State
+ *
+ * Description       : hsm state object
+ *                     the state object describes only the hsm tree topology
+ *                     and can be shared by any number of hsm definitions
+ *                     all children of the parallel state are orthogonal regions,
+ *                     active at the same time while the parallel state is active
+ *                     the state with history is re-entered to its child state (Shallow)
+ *                     or to its descendant state (Deep) active at the last exit, instead of Init
+ *
+ * Constructor parameters
+ *            parent : state parent in the hsm tree
+ *              kind : state kind (State::Exclusive / State::Parallel / State::Shallow / State::Deep)
+ *
+ ******************************************************************************/
+
+struct State
+{
+	enum Kind : unsigned char
+	{
+		Exclusive,// at most one child state is active
+		Parallel, // all child states (orthogonal regions) are active
+		Shallow,  // exclusive state with shallow history
+		Deep,     // exclusive state with deep history
+	};
+
+	constexpr State() {}
+	constexpr State( State& parent_ ): parent{&parent_} {}
+	constexpr State( Kind kind_ ): kind{kind_} {}
+	constexpr State( State& parent_, Kind kind_ ): parent{&parent_}, kind{kind_} {}
+
+	State( State&& ) = default;
+	State( const State& ) = delete;
+	State& operator=( State&& ) = delete;
+	State& operator=( const State& ) = delete;
+
+/* -------------------------------------------------------------------------- */
+
+	private:
+	State *parent{}; // pointer to parent state in the hsm tree
+	Kind kind{};     // state kind: exclusive, parallel or with history
+
+	friend struct Definition;
+	friend struct StateMachine;
+	template<class E, std::size_t N>
+	friend struct EnumDefinition;
+};
+
+/******************************************************************************
+ *
+ * Class             : Action
+ *
+ * Description       : hsm action object
+ *                     the event handler is constructed in place from the given callable object
+ *                     guarded direct transitions of the state and event are evaluated in order
+ *                     before the unguarded action; if no guard passes and there's no unguarded action,
+ *                     the user event is handled by the ancestor state
+ *
+ * Constructor parameters
+ *             owner : hsm action owner (State)
+ *             event : hsm action event value
+ *             guard : guard of the direct transition (Guard)
+ *    handler, state : transition target state or event handler (callable object)
+ *                or
+ *             defer : Defer tag; the user event is deferred in the owner state
+ *                or
+ *           timeout : state timeout (Timeout); the user event is sent after the delay in the owner state
+ *
+ ******************************************************************************/
+
+struct Action
+{
+	Action( State& owner_, unsigned event_ ):                   owner{owner_}, event{event_}, action{& owner_} {}
+	Action( State& owner_, unsigned event_, State&  state_ ):   owner{owner_}, event{event_}, action{& state_} {}
+	Action( State& owner_, unsigned event_, Guard guard_, State& state_ ): owner{owner_}, event{event_}, action{& state_}, guard{guard_} {}
+	Action( State& owner_, unsigned event_, Defer ):            owner{owner_}, event{event_}, action{static_cast<State*>(nullptr)} {}
+	Action( State& owner_, unsigned event_, Timeout timeout_ ): owner{owner_}, event{event_}, action{& owner_}, delay{timeout_.delay} { assert(timeout_.delay > 0); }
+
+	template<class F, std::enable_if_t<std::is_constructible_v<Handler, F&&> && !std::is_same_v<std::decay_t<F>, State> && !std::is_same_v<std::decay_t<F>, Defer> && !std::is_same_v<std::decay_t<F>, Timeout>, int> = 0>
+	Action( State& owner_, unsigned event_, F&& handler_ ):     owner{owner_}, event{event_}, action{std::in_place_type<Handler>, std::forward<F>(handler_)} {}
+
+	Action( Action&& ) = default;
+	Action( const Action& ) = default;
+	Action& operator=( Action&& ) = delete;
+	Action& operator=( const Action& ) = delete;
+
+/* -------------------------------------------------------------------------- */
+
+	private:
+	State&   owner; // action owner state
+	unsigned event; // action event value
+	Variant action; // transition target state (nullptr for the deferred event) or event handler
+	Guard guard{};  // optional guard of the direct transition
+	unsigned delay{}; // delay of the state timeout (0 if the action is not the timeout)
+
+	friend struct Definition;
+	friend struct StateMachine;
+	friend struct LiveDefinition;
+	template<class E, std::size_t N>
+	friend struct EnumDefinition;
+};
+
+/******************************************************************************
+ *
+ * Class             : Definition
+ *
+ * Description       : hsm definition object
+ *                     immutable set of hsm actions with compiled dispatch tables,
+ *                     can be shared by any number of hsm instances
+ *                     all states reached by the hsm must be used by the action table
+ *                     or added to the definition with function 'add'
+ *
+ * Constructor parameters
+ *               tab : set of hsm actions
+ *          resource : memory resource providing all storage of the definition
+ *                     (default: hsm::defaultResource())
+ *
+ ******************************************************************************/
+
+struct Definition
+{
+	static constexpr unsigned none = ~0U; // index of the 'no state' / 'no action'
+
+	enum Finding : unsigned { Unreachable, Overridden, Shadowed, Collapsed }; // kinds of findings of the compilation
+
+	struct Diagnostic
+	{
+		Finding finding;     // kind of the finding
+		const State *state;  // state or owner state of the action
+		unsigned event;      // event value of the action (Event::ALL for the state)
+	};
+
+	Definition(): Definition(defaultResource()) {}
+	explicit Definition( std::pmr::memory_resource *resource_ ):
+		tab(resource_), extra(resource_), states(resource_), index(resource_), events(resource_), handlers(resource_), guards(resource_), data(resource_), diagnostics(resource_) {}
+	Definition( const Table& tab_, std::pmr::memory_resource *resource_ = defaultResource() ):
+		Definition(resource_) { Definition::add(tab_); Definition::compile(); }
+#ifndef HSM_FREESTANDING
+	Definition( Table&& tab_, std::pmr::memory_resource *resource_ = defaultResource() ):
+		Definition(resource_) { Definition::add(std::move(tab_)); Definition::compile(); }
+#endif
+
+	Definition( Definition&& ) = default;
+	Definition( const Definition& ) = delete;
+	Definition& operator=( Definition&& ) = delete;
+	Definition& operator=( const Definition& ) = delete;
+
+/******************************************************************************
+ * Name              : hsm::Definition::add
+ * Description       : add set of hsm actions to the hsm definition
+ *               tab : set of hsm actions
+ * Return            : none
+ * Note              : definition must be compiled again before use
+ ******************************************************************************/
+
+	void add( const Table& tab_ )
+	{
+		Definition::tab.reserve(Definition::tab.size() + tab_.size());
+		std::copy(std::begin(tab_), std::end(tab_), std::back_inserter(Definition::tab));
+		Definition::ready = false;
+	}
+
+#ifndef HSM_FREESTANDING
+/******************************************************************************
+ * Name              : hsm::Definition::add
+ * Description       : move set of hsm actions to the hsm definition
+ *               tab : set of hsm actions
+ * Return            : none
+ * Note              : definition must be compiled again before use
+ ******************************************************************************/
+
+	void add( Table&& tab_ )
+	{
+		Definition::tab.reserve(Definition::tab.size() + tab_.size());
+		std::move(std::begin(tab_), std::end(tab_), std::back_inserter(Definition::tab));
+		tab_.clear();
+		Definition::ready = false;
+	}
+#endif
+
+/******************************************************************************
+ * Name              : hsm::Definition::resource
+ * Description       : get the memory resource of the definition
+ * Parameters        : none
+ * Return            : memory resource providing all storage of the definition
+ ******************************************************************************/
+
+	std::pmr::memory_resource* resource() const
+	{
+		return Definition::tab.get_allocator().resource();
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::add
+ * Description       : add hsm action with given parameters to the hsm definition
+ * Parameters        :
+ *             owner : hsm action owner (State)
+ *             event : hsm action event value
+ *    handler, state : variant parameter for hsm action constructor
+ * Return            : none
+ * Note              : definition must be compiled again before use
+ ******************************************************************************/
+
+	template<class T>
+	void add( State& owner_, unsigned event_, T&& action_ )
+	{
+		Definition::tab.emplace_back(owner_, event_, std::forward<T>(action_));
+		Definition::ready = false;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::reserve
+ * Description       : reserve storage for the given number of hsm actions
+ * Parameters        :
+ *             count : expected number of hsm actions
+ * Return            : none
+ ******************************************************************************/
+
+	void reserve( std::size_t count_ )
+	{
+		Definition::tab.reserve(count_);
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::add
+ * Description       : add hsm state without actions, reached only by transition from event handler
+ * Parameters        :
+ *             state : hsm state
+ * Return            : none
+ * Note              : definition must be compiled again before use
+ ******************************************************************************/
+
+	void add( State& state_ )
+	{
+		Definition::extra.push_back(&state_);
+		Definition::ready = false;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::compile
+ * Description       : build the state tree and dispatch tables of the hsm definition
+ *                     each table maps event value to the handling action,
+ *                     user events are resolved to the handling ancestor state,
+ *                     the last table column is used for all other event values
+ * Parameters        : none
+ * Return            : none
+ ******************************************************************************/
+
+	void compile()
+	{
+		std::pmr::unordered_set<const State *> inserted_(Definition::resource()); // states already inserted
+		inserted_.reserve(Definition::tab.size() + Definition::extra.size());
+		Definition::states.clear();
+		for (auto& action_: Definition::tab)
+		{
+			Definition::insert(&action_.owner, inserted_);
+			if (std::holds_alternative<State*>(action_.action))
+				Definition::insert(std::get<State*>(action_.action), inserted_);
+		}
+		for (auto state_: Definition::extra)
+			Definition::insert(state_, inserted_);
+
+		Definition::index.clear();
+		Definition::index.reserve(Definition::states.size());
+		for (unsigned state_ = 0; state_ < Definition::states.size(); state_++)
+			Definition::index.emplace_back(Definition::states[state_], state_);
+		std::sort(std::begin(Definition::index), std::end(Definition::index));
+
+		// all tables are reserved with their final size, so no storage of the memory resource is outgrown
+		std::size_t paths_ = 0;
+		for (auto state_: Definition::states)
+			for (auto prev_ = state_; prev_ != nullptr; prev_ = prev_->parent)
+				paths_++;
+
+		std::pmr::vector<unsigned> nodes_(Definition::resource()); // parent, level and path of each state
+		std::pmr::vector<unsigned> tree_(Definition::resource());  // state paths
+		nodes_.reserve(Definition::states.size() * NodeSize);
+		tree_.reserve(paths_);
+		for (auto state_: Definition::states)
+		{
+			unsigned parent_ = Definition::find(state_->parent);
+			unsigned level_ = parent_ != none ? nodes_[parent_ * NodeSize + Level] + 1 : 1;
+			unsigned path_ = static_cast<unsigned>(tree_.size());
+
+			tree_.resize(path_ + level_);
+			nodes_.insert(std::end(nodes_), { parent_, level_, path_ });
+			for (auto prev_ = state_; prev_ != nullptr; prev_ = prev_->parent)
+				tree_[path_ + --level_] = Definition::find(prev_);
+		}
+
+		std::pmr::vector<unsigned> links_(Definition::resource()); // owner, target, root, handler slot, guard slot and next guarded (or chained) action of each action
+		links_.reserve(Definition::tab.size() * LinkSize);
+		Definition::handlers.clear();
+		Definition::handlers.reserve(static_cast<std::size_t>(std::count_if(std::begin(Definition::tab), std::end(Definition::tab),
+			[]( const Action& action_ ){ return std::holds_alternative<Handler>(action_.action); })));
+		Definition::guards.clear();
+		Definition::guards.reserve(static_cast<std::size_t>(std::count_if(std::begin(Definition::tab), std::end(Definition::tab),
+			[]( const Action& action_ ){ return action_.guard != nullptr; })));
+		for (auto& action_: Definition::tab)
+		{
+			unsigned owner_ = Definition::find(&action_.owner);
+			unsigned target_ = none;
+			unsigned slot_ = none;
+			unsigned guard_ = none;
+
+			if (action_.guard != nullptr)
+			{
+				assert(action_.event == Event::Init || action_.event >= Event::User);
+
+				guard_ = static_cast<unsigned>(Definition::guards.size());
+				Definition::guards.push_back(action_.guard);
+			}
+
+			if (std::holds_alternative<State*>(action_.action))
+				target_ = Definition::find(std::get<State*>(action_.action));
+			else
+			{
+				slot_ = static_cast<unsigned>(Definition::handlers.size());
+				Definition::handlers.push_back(&std::get<Handler>(action_.action));
+			}
+
+			links_.insert(std::end(links_), { owner_, target_, none, slot_, guard_, none });
+
+			assert(action_.event >= Event::User || target_ != none || slot_ != none); // only user events can be deferred
+			assert(action_.event >= Event::User || action_.delay == 0); // state timeouts send user events
+
+			assert(action_.event != Event::Init || action_.owner.kind != State::Parallel); // regions of the parallel state are entered instead
+		}
+
+		std::pmr::vector<unsigned> sections_(Definition::resource()); // region, first and last region of each state
+		std::pmr::vector<unsigned> origins_(Definition::resource());  // root state of each orthogonal region
+		if (std::any_of(std::begin(Definition::states), std::end(Definition::states), []( const State *state_ ){ return state_->kind == State::Parallel; }))
+		{
+			sections_.resize(Definition::states.size() * SectionSize, none);
+			origins_.reserve(1 + static_cast<std::size_t>(std::count_if(std::begin(Definition::states), std::end(Definition::states),
+				[]( const State *state_ ){ return state_->parent != nullptr && state_->parent->kind == State::Parallel; })));
+			origins_.push_back(none); // region 0 is the whole hsm
+			for (unsigned state_ = 0; state_ < Definition::states.size(); state_++)
+			{
+				if (Definition::states[state_]->kind != State::Parallel)
+					continue;
+
+				// regions of the parallel state are numbered consecutively in the order of states
+				for (unsigned child_ = state_ + 1; child_ < Definition::states.size(); child_++)
+				{
+					if (nodes_[child_ * NodeSize + Parent] != state_)
+						continue;
+
+					unsigned region_ = static_cast<unsigned>(origins_.size());
+					if (sections_[state_ * SectionSize + Branch] == none)
+						sections_[state_ * SectionSize + Branch] = region_;
+					sections_[state_ * SectionSize + Bound] = region_ + 1;
+					sections_[child_ * SectionSize + Region] = region_;
+					origins_.push_back(child_);
+				}
+			}
+
+			for (unsigned state_ = 0; state_ < Definition::states.size(); state_++)
+			{
+				unsigned parent_ = nodes_[state_ * NodeSize + Parent];
+				if (sections_[state_ * SectionSize + Region] == none)
+					sections_[state_ * SectionSize + Region] = parent_ != none ? sections_[parent_ * SectionSize + Region] : 0;
+			}
+		}
+		Definition::regions = origins_.empty() ? 0 : static_cast<unsigned>(origins_.size() - 1);
+
+		std::pmr::vector<unsigned> memories_(Definition::resource()); // history slot and history mode of each state
+		Definition::memories = 0;
+		if (std::any_of(std::begin(Definition::states), std::end(Definition::states), []( const State *state_ ){ return state_->kind >= State::Shallow; }))
+		{
+			memories_.resize(Definition::states.size() * MemorySize, none);
+			for (unsigned state_ = 0; state_ < Definition::states.size(); state_++)
+			{
+				if (Definition::states[state_]->kind < State::Shallow)
+					continue;
+
+				memories_[state_ * MemorySize + Memory] = Definition::memories++;
+				memories_[state_ * MemorySize + Mode] = Definition::states[state_]->kind == State::Deep;
+			}
+		}
+
+		Definition::events.clear();
+		Definition::events.reserve(3 + static_cast<std::size_t>(std::count_if(std::begin(Definition::tab), std::end(Definition::tab),
+			[]( const Action& action_ ){ return action_.event >= Event::User; })));
+		Definition::events.insert(std::end(Definition::events), { Event::Exit, Event::Entry, Event::Init });
+		for (auto& action_: Definition::tab)
+			if (action_.event >= Event::User)
+				Definition::events.push_back(action_.event);
+		std::sort(std::begin(Definition::events), std::end(Definition::events));
+		Definition::events.erase(std::unique(std::begin(Definition::events), std::end(Definition::events)), std::end(Definition::events));
+
+		Definition::width = static_cast<unsigned>(Definition::events.size() + 1);
+
+		std::pmr::vector<unsigned> columns_(Definition::resource()); // dense map of event value to dispatch table column
+		if (Definition::events.back() < 2 * Definition::width + Event::User) // event values are dense enough
+		{
+			columns_.resize(Definition::events.back() + 1, Definition::width - 1);
+			for (unsigned column_ = 0; column_ < Definition::events.size(); column_++)
+				columns_[Definition::events[column_]] = column_;
+		}
+		Definition::range = static_cast<unsigned>(columns_.size());
+
+		std::pmr::vector<unsigned> lut_(Definition::states.size() * Definition::width, none, Definition::resource());
+		for (unsigned action_ = 0; action_ < Definition::tab.size(); action_++)
+		{
+			unsigned *table_ = &lut_[links_[action_ * LinkSize + Owner] * Definition::width];
+			unsigned event_ = Definition::tab[action_].event;
+
+			if (links_[action_ * LinkSize + Check] != none || Definition::tab[action_].delay != 0)
+				continue;
+
+			if (event_ == Event::ALL)
+				std::fill(table_, table_ + Definition::width, action_);
+			else
+			if (event_ >= Event::Exit)
+				table_[Definition::getColumn(event_, columns_)] = action_;
+		}
+
+		// the unguarded action overridden in the dispatch table of its owner by a later action can never fire,
+		// it is reported and dropped; remaining actions are renumbered in order
+		Definition::diagnostics.clear();
+		std::pmr::vector<unsigned> actions_(Definition::resource());  // action table index of each compiled action
+		std::pmr::vector<unsigned> compact_(Definition::tab.size(), none, Definition::resource()); // compiled action of each action table index
+		actions_.reserve(Definition::tab.size());
+		for (unsigned action_ = 0; action_ < Definition::tab.size(); action_++)
+		{
+			const Action& item_ = Definition::tab[action_];
+			const unsigned *table_ = &lut_[links_[action_ * LinkSize + Owner] * Definition::width];
+			unsigned winner_ = action_;
+
+			if (links_[action_ * LinkSize + Check] == none && item_.delay == 0)
+			{
+				if (item_.event == Event::ALL)
+				{
+					// the last column is filled only for all events, so the action is in the table if it's there
+					if (table_[Definition::width - 1] != action_)
+						winner_ = table_[0];
+				}
+				else
+				if (item_.event >= Event::Exit)
+					winner_ = table_[Definition::getColumn(item_.event, columns_)];
+			}
+
+			if (winner_ != action_)
+			{
+				Definition::diagnostics.push_back({ Definition::tab[winner_].event == Event::ALL ? Shadowed : Overridden, &item_.owner, item_.event });
+				continue;
+			}
+
+			unsigned compiled_ = static_cast<unsigned>(actions_.size());
+			std::copy_n(&links_[action_ * LinkSize], LinkSize, &links_[compiled_ * LinkSize]);
+			compact_[action_] = compiled_;
+			actions_.push_back(action_);
+		}
+		links_.resize(actions_.size() * LinkSize);
+		for (unsigned& entry_: lut_)
+			if (entry_ != none)
+				entry_ = compact_[entry_];
+
+		std::pmr::vector<unsigned> guarded_(Definition::resource()); // guarded actions in reverse order, grouped by owner
+		guarded_.reserve(Definition::guards.size());
+		for (unsigned action_ = static_cast<unsigned>(actions_.size()); action_-- > 0;)
+			if (links_[action_ * LinkSize + Check] != none)
+				guarded_.push_back(action_);
+		Definition::order(guarded_, [&links_]( unsigned action_, unsigned other_ ){
+			return links_[action_ * LinkSize + Owner] < links_[other_ * LinkSize + Owner]; });
+
+		auto guarded_item_ = std::begin(guarded_);
+		for (unsigned state_ = 0; state_ < Definition::states.size(); state_++)
+		{
+			unsigned parent_ = nodes_[state_ * NodeSize + Parent];
+			if (parent_ != none)
+				for (unsigned column_ = Event::User - Event::Exit; column_ < Definition::width; column_++)
+					if (lut_[state_ * Definition::width + column_] == none)
+						lut_[state_ * Definition::width + column_] = lut_[parent_ * Definition::width + column_];
+
+			// guarded actions are chained in order before the action resolved for the state
+			for (; guarded_item_ != std::end(guarded_) && links_[*guarded_item_ * LinkSize + Owner] == state_; ++guarded_item_)
+			{
+				unsigned *entry_ = &lut_[state_ * Definition::width + Definition::getColumn(Definition::tab[actions_[*guarded_item_]].event, columns_)];
+				links_[*guarded_item_ * LinkSize + Next] = *entry_;
+				*entry_ = *guarded_item_;
+			}
+		}
+
+		// states not entered by any direct transition from the states which can be entered are reported,
+		// they can still be the targets of transitions set by event handlers
+		std::pmr::vector<bool> reached_(Definition::states.size(), false, Definition::resource());
+		for (unsigned state_ = 0; state_ < Definition::states.size(); state_++)
+			reached_[state_] = nodes_[state_ * NodeSize + Parent] == none; // any top-level state can be started
+		for (auto state_: Definition::extra)
+			reached_[Definition::find(state_)] = true;
+		for (bool changed_ = true; changed_;)
+		{
+			changed_ = false;
+			for (unsigned state_ = 0; state_ < Definition::states.size(); state_++)
+			{
+				unsigned parent_ = nodes_[state_ * NodeSize + Parent];
+				if (!reached_[state_] && parent_ != none && reached_[parent_] && Definition::states[parent_]->kind == State::Parallel)
+					reached_[state_] = changed_ = true; // regions of the parallel state are entered together
+			}
+			for (unsigned action_ = 0; action_ < actions_.size(); action_++)
+			{
+				unsigned target_ = links_[action_ * LinkSize + Target];
+				if (!reached_[links_[action_ * LinkSize + Owner]])
+					continue;
+				for (; target_ != none && !reached_[target_]; target_ = nodes_[target_ * NodeSize + Parent])
+					reached_[target_] = changed_ = true;
+			}
+		}
+		for (unsigned state_ = 0; state_ < Definition::states.size(); state_++)
+			if (!reached_[state_])
+				Definition::diagnostics.push_back({ Unreachable, Definition::states[state_], Event::ALL });
+
+		// the pure Init transition to the state handling Init with the pure transition again
+		// is extended to the final target, so the chain is done by a single transition
+		// the chain stops at the state with history or regions; the first chained action is kept
+		// in the unused 'Next' field of the collapsed action, so the trace can record the whole chain
+		auto pure_ = [&links_]( unsigned action_ ){
+			return action_ != none && links_[action_ * LinkSize + Target] != none &&
+			       links_[action_ * LinkSize + Slot] == none && links_[action_ * LinkSize + Check] == none; };
+		for (unsigned action_ = 0; action_ < actions_.size(); action_++)
+		{
+			const Action& item_ = Definition::tab[actions_[action_]];
+			if (item_.event != Event::Init || !pure_(action_))
+				continue;
+
+			unsigned target_ = links_[action_ * LinkSize + Target];
+			unsigned chain_ = none;
+			while (Definition::states[target_]->kind == State::Exclusive)
+			{
+				unsigned next_ = lut_[target_ * Definition::width + Event::Init - Event::Exit];
+				if (!pure_(next_) || links_[next_ * LinkSize + Target] == target_)
+					break;
+				if (chain_ == none)
+					chain_ = next_;
+				target_ = links_[next_ * LinkSize + Target];
+			}
+
+			if (target_ == links_[action_ * LinkSize + Target])
+				continue;
+
+			Definition::diagnostics.push_back({ Collapsed, &item_.owner, Event::Init });
+			links_[action_ * LinkSize + Target] = target_;
+			links_[action_ * LinkSize + Next] = chain_;
+		}
+
+		std::pmr::vector<unsigned> timeouts_(Definition::resource()); // actions of state timeouts, grouped by owner
+		timeouts_.reserve(static_cast<std::size_t>(std::count_if(std::begin(actions_), std::end(actions_),
+			[this]( unsigned action_ ){ return Definition::tab[action_].delay != 0; })));
+		for (unsigned action_ = 0; action_ < actions_.size(); action_++)
+			if (Definition::tab[actions_[action_]].delay != 0)
+				timeouts_.push_back(action_);
+		Definition::order(timeouts_, [&links_]( unsigned action_, unsigned other_ ){
+			return links_[action_ * LinkSize + Owner] < links_[other_ * LinkSize + Owner]; });
+
+		std::pmr::vector<unsigned> timers_(Definition::resource()); // owner, column and delay of each state timeout
+		timers_.reserve(timeouts_.size() * TimerSize);
+		for (unsigned action_: timeouts_)
+			timers_.insert(std::end(timers_), { links_[action_ * LinkSize + Owner], Definition::getColumn(Definition::tab[actions_[action_]].event, columns_), Definition::tab[actions_[action_]].delay });
+		Definition::timeouts = static_cast<unsigned>(timeouts_.size());
+
+		// pack all compiled tables into one contiguous arena
+		Definition::data.clear();
+		Definition::data.reserve(nodes_.size() + links_.size() + lut_.size() + columns_.size() + tree_.size() + sections_.size() + origins_.size() + memories_.size() + timers_.size());
+
+		Index *nodes_data_    = Definition::pack(nodes_);
+		Index *links_data_    = Definition::pack(links_);
+		Index *lut_data_      = Definition::pack(lut_);
+		Index *columns_data_  = Definition::pack(columns_);
+		Index *tree_data_     = Definition::pack(tree_);
+		Index *sections_data_ = Definition::pack(sections_);
+		Index *origins_data_  = Definition::pack(origins_);
+		Index *memories_data_ = Definition::pack(memories_);
+		Index *timers_data_   = Definition::pack(timers_);
+
+		Definition::nodes    = nodes_data_;
+		Definition::links    = links_data_;
+		Definition::lut      = lut_data_;
+		Definition::columns  = columns_data_;
+		Definition::tree     = tree_data_;
+		Definition::sections = sections_data_;
+		Definition::origins  = origins_data_;
+		Definition::history  = memories_data_;
+		Definition::timers   = timers_data_;
+		Definition::length   = Definition::data.size();
+		Definition::values   = Definition::events.data();
+		Definition::slots    = Definition::handlers.data();
+		Definition::count    = Definition::handlers.size();
+		Definition::checks   = Definition::guards.data();
+		Definition::guarded  = Definition::guards.size();
+
+		for (unsigned action_ = 0; action_ < actions_.size(); action_++)
+		{
+			Index *link_ = &links_data_[action_ * LinkSize];
+			if (link_[Target] != Definition::put(none))
+				link_[Root] = Definition::put(Definition::getRoot(Definition::get(link_[Owner]), Definition::get(link_[Target])));
+		}
+
+		Definition::ready = true;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::id
+ * Description       : get the id of the given hsm state in the compiled definition
+ *                     the id is the position of the state in the array of states bound to the loaded definition
+ * Parameters        :
+ *             state : hsm state
+ * Return            : state id or 'none' if the state is not used by the hsm
+ ******************************************************************************/
+
+	unsigned id( const State& state_ ) const
+	{
+		return Definition::find(&state_);
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::diagnose
+ * Description       : get the findings of the last compilation of the definition:
+ *                     - Unreachable: the state is not entered by any direct transition (it can be entered
+ *                       only by the transition set in the event handler)
+ *                     - Overridden: the action can never fire, as the later action of the owner state
+ *                       handles the same event; the action has been dropped
+ *                     - Shadowed: the action can never fire, as the later Event::ALL action of the owner state
+ *                       handles all events; the action has been dropped
+ *                     - Collapsed: the Init transition of the state resolves statically through the chain
+ *                       of Init transitions; it has been replaced with the transition to the final target
+ * Parameters        :
+ *               tab : array for the findings or nullptr
+ * Return            : number of findings
+ ******************************************************************************/
+
+	std::size_t diagnose( Diagnostic *tab_ ) const
+	{
+		if (tab_ != nullptr)
+			std::copy(std::begin(Definition::diagnostics), std::end(Definition::diagnostics), tab_);
+
+		return Definition::diagnostics.size();
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::save
+ * Description       : write the compiled definition as a binary image
+ *                     the image contains the state tree, the dispatch tables, handler and guard slot ids;
+ *                     the slot id of the event handler (guard) is its position among all event handlers (guards)
+ *                     of the action table, in the order of adding
+ * Parameters        :
+ *              file : binary output file
+ * Return            : true if the image has been written successfully
+ ******************************************************************************/
+
+	bool save( std::FILE *file_ ) const
+	{
+		assert(Definition::ready);
+
+		Image image_{};
+		std::memcpy(image_.magic, Image::signature, sizeof(image_.magic));
+		image_.version  = Image::revision;
+		image_.index    = sizeof(Index);
+		image_.states   = static_cast<std::uint32_t>(Definition::states.size());
+		image_.handlers = static_cast<std::uint32_t>(Definition::count);
+		image_.guards   = static_cast<std::uint32_t>(Definition::guarded);
+		image_.width    = Definition::width;
+		image_.range    = Definition::range;
+		image_.length   = static_cast<std::uint32_t>(Definition::length);
+		image_.links    = static_cast<std::uint32_t>(Definition::links   - Definition::nodes);
+		image_.lut      = static_cast<std::uint32_t>(Definition::lut     - Definition::nodes);
+		image_.columns  = static_cast<std::uint32_t>(Definition::columns - Definition::nodes);
+		image_.tree     = static_cast<std::uint32_t>(Definition::tree    - Definition::nodes);
+		image_.regions  = Definition::regions;
+		image_.sections = static_cast<std::uint32_t>(Definition::sections - Definition::nodes);
+		image_.origins  = static_cast<std::uint32_t>(Definition::origins  - Definition::nodes);
+		image_.memories = Definition::memories;
+		image_.history  = static_cast<std::uint32_t>(Definition::history  - Definition::nodes);
+		image_.timeouts = Definition::timeouts;
+		image_.timers   = static_cast<std::uint32_t>(Definition::timers   - Definition::nodes);
+
+		const std::size_t events_ = Definition::width - 1;
+		const std::size_t padding_ = Image::offset(image_.width) - sizeof(image_) - events_ * sizeof(unsigned);
+		const char zeros_[alignof(std::uint64_t)]{};
+
+		return std::fwrite(&image_, sizeof(image_), 1, file_) == 1 &&
+		       std::fwrite(Definition::values, sizeof(unsigned), events_, file_) == events_ &&
+		       std::fwrite(zeros_, 1, padding_, file_) == padding_ &&
+		       std::fwrite(Definition::nodes, sizeof(Index), Definition::length, file_) == Definition::length;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::load
+ * Description       : use the binary image written by the function 'save' in place
+ *                     (e.g. memory-mapped file); the image is neither copied nor parsed
+ *                     and must stay valid and unchanged while the definition is used
+ * Parameters        :
+ *             image : pointer to the image (aligned to 8 bytes)
+ *              size : size of the image in bytes
+ *             slots : registry of event handlers: handler for each slot id
+ *             count : number of event handlers in the registry
+ *            states : hsm states for each state id
+ *            number : number of hsm states
+ *            guards : registry of guards: guard for each slot id
+ *             total : number of guards in the registry
+ * Return            : false if the image is not valid for this build or does not match the registry
+ * Note              : the definition must be empty; the only storage allocated is the state index
+ ******************************************************************************/
+
+	bool load( const void *image_, std::size_t size_, const Handler *const *slots_, std::size_t count_, State *const *states_, std::size_t number_,
+	           const Guard *guards_ = nullptr, std::size_t total_ = 0 )
+	{
+		assert(Definition::tab.empty());
+
+		const Image *header_ = static_cast<const Image *>(image_);
+		if (!Definition::verify(image_, size_) ||
+		    header_->states != number_ || header_->handlers != count_ || header_->guards != total_)
+			return false;
+
+		const unsigned *values_ = reinterpret_cast<const unsigned *>(header_ + 1);
+		const Index *nodes_ = reinterpret_cast<const Index *>(static_cast<const char *>(image_) + Image::offset(header_->width));
+
+		if (states_ != nullptr)
+			Definition::states.assign(states_, states_ + number_);
+		else
+			Definition::states.assign(number_, nullptr);
+		Definition::index.clear();
+		Definition::index.reserve(number_);
+		for (unsigned state_ = 0; state_ < Definition::states.size(); state_++)
+			Definition::index.emplace_back(Definition::states[state_], state_);
+		std::sort(std::begin(Definition::index), std::end(Definition::index));
+
+		Definition::nodes    = nodes_;
+		Definition::links    = nodes_ + header_->links;
+		Definition::lut      = nodes_ + header_->lut;
+		Definition::columns  = nodes_ + header_->columns;
+		Definition::tree     = nodes_ + header_->tree;
+		Definition::sections = nodes_ + header_->sections;
+		Definition::origins  = nodes_ + header_->origins;
+		Definition::regions  = header_->regions;
+		Definition::history  = nodes_ + header_->history;
+		Definition::memories = header_->memories;
+		Definition::timers   = nodes_ + header_->timers;
+		Definition::timeouts = header_->timeouts;
+		Definition::length   = header_->length;
+		Definition::values   = values_;
+		Definition::slots    = slots_;
+		Definition::count    = count_;
+		Definition::checks   = guards_;
+		Definition::guarded  = total_;
+		Definition::range    = header_->range;
+		Definition::width    = header_->width;
+		Definition::ready    = true;
+
+		return true;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::inspect
+ * Description       : load the binary image written by the function 'save' for inspection only
+ *                     the state tree and the dispatch tables are available (e.g. for tools),
+ *                     no states, event handlers and guards are bound; the definition cannot be run
+ * Parameters        :
+ *             image : pointer to the image, aligned to 8 bytes; the image must outlive the definition
+ *              size : size of the image
+ * Return            : false if the image is not valid for this build
+ * Note              : the definition must be empty; the only storage allocated is the state index
+ ******************************************************************************/
+
+	bool inspect( const void *image_, std::size_t size_ )
+	{
+		if (!Definition::verify(image_, size_))
+			return false;
+
+		const Image *header_ = static_cast<const Image *>(image_);
+
+		return Definition::load(image_, size_, nullptr, header_->handlers, nullptr, header_->states, nullptr, header_->guards);
+	}
+
+/* -------------------------------------------------------------------------- */
+
+	private:
+#ifdef HSM_SMALL_INDEX
+	using Index = std::uint16_t;         // storage type of indices in compiled tables
+#else
+	using Index = unsigned;              // storage type of indices in compiled tables
+#endif
+
+	enum: unsigned { Parent, Level, Path, NodeSize };          // fields of the compiled state
+	enum: unsigned { Owner, Target, Root, Slot, Check, Next, LinkSize }; // fields of the compiled action
+	enum: unsigned { Region, Branch, Bound, SectionSize };     // fields of the compiled orthogonal regions of the state
+	enum: unsigned { Memory, Mode, MemorySize };               // fields of the compiled history of the state
+	enum: unsigned { Scope, Column, Delay, TimerSize };        // fields of the compiled state timeout
+
+	static_assert(sizeof(unsigned) == sizeof(std::uint32_t), "event values of the image require 32-bit unsigned");
+
+	struct Image
+	{
+		static constexpr char signature[4]{'H', 'S', 'M', 'D'};
+		static constexpr std::uint32_t revision = 5;
+
+		char          magic[4]; // image signature
+		std::uint32_t version;  // image format version
+		std::uint32_t index;    // size of the stored index
+		std::uint32_t states;   // number of states
+		std::uint32_t handlers; // number of event handler slots
+		std::uint32_t guards;   // number of guard slots
+		std::uint32_t width;    // number of dispatch table columns
+		std::uint32_t range;    // size of the dense map of event values
+		std::uint32_t length;   // number of indices in the arena of compiled tables
+		std::uint32_t links;    // offsets of compiled tables in the arena; the state tree is at offset 0
+		std::uint32_t lut;      // *
+		std::uint32_t columns;  // *
+		std::uint32_t tree;     // *
+		std::uint32_t sections; // *
+		std::uint32_t origins;  // *
+		std::uint32_t history;  // *
+		std::uint32_t regions;  // number of orthogonal regions
+		std::uint32_t memories; // number of states with history
+		std::uint32_t timers;   // offset of compiled state timeouts in the arena
+		std::uint32_t timeouts; // number of state timeouts
+
+		// the header is followed by the event values of (width - 1) columns
+		// and the arena of compiled tables, aligned to 8 bytes
+
+		static std::size_t offset( std::uint32_t width_ )
+		{
+			std::size_t offset_ = sizeof(Image) + (width_ - 1) * sizeof(std::uint32_t);
+			return (offset_ + alignof(std::uint64_t) - 1) / alignof(std::uint64_t) * alignof(std::uint64_t);
+		}
+	};
+
+	struct Link
+	{
+		unsigned owner;  // index of action owner state
+		unsigned target; // index of direct transition target state
+		unsigned root;   // index of direct transition root state
+	};
+
+	std::pmr::vector<Action> tab;        // set of hsm actions
+	std::pmr::vector<const State*> extra;// states added without actions
+	std::pmr::vector<const State*> states; // states used by the hsm, parents precede children
+	std::pmr::vector<std::pair<const State*, unsigned>> index; // states sorted for the state index lookup
+	std::pmr::vector<unsigned> events;   // event values assigned to the dispatch table columns
+	std::pmr::vector<const Handler*> handlers; // event handlers of actions (cold data)
+	std::pmr::vector<Guard> guards; // guards of direct transitions (cold data)
+	std::pmr::vector<Index> data;        // arena of compiled tables (hot data)
+	std::pmr::vector<Diagnostic> diagnostics; // findings of the compilation (cold data)
+	std::size_t length{};           // number of indices in the arena of compiled tables
+	const unsigned *values{};       // event values assigned to the dispatch table columns (events or image)
+	const Handler *const *slots{};  // event handlers of actions (handlers or registry)
+	std::size_t count{};            // number of event handlers
+	const Guard *checks{};          // guards of direct transitions (guards or registry)
+	std::size_t guarded{};          // number of guards
+	const Index *nodes{};           // compiled state tree: parent, level and path of each state
+	const Index *links{};           // compiled actions: owner, target, root and handler slot
+	const Index *lut{};             // dispatch tables: action index for each state and column
+	const Index *columns{};         // dense map of event value to dispatch table column
+	const Index *tree{};            // storage of state paths
+	const Index *sections{};        // compiled regions: region of each state, first and last region of the parallel state
+	const Index *origins{};         // root state of each orthogonal region
+	const Index *history{};         // compiled history: history slot and mode (0: shallow, 1: deep) of each state
+	unsigned regions{};             // number of orthogonal regions (0 if the hsm has no parallel states)
+	unsigned memories{};            // number of states with history
+	const Index *timers{};          // compiled state timeouts: owner, column and delay of each timeout, grouped by owner
+	unsigned timeouts{};            // number of state timeouts
+	unsigned range{};               // size of the dense map of event values
+	unsigned width{};               // number of dispatch table columns
+	bool ready{};                   // the definition has been compiled
+	StateMachine *owner{};          // hsm instance owning the private definition
+
+/******************************************************************************
+ * Name              : hsm::Definition::put
+ * Description       : convert index to its storage type
+ * Parameters        :
+ *             index : index or 'none'
+ * Return            : stored index
+ * Note              : for internal use
+ ******************************************************************************/
+
+	static Index put( unsigned index_ )
+	{
+		assert(index_ == none || index_ < static_cast<Index>(none));
+
+		return static_cast<Index>(index_);
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::get
+ * Description       : convert stored index to index
+ * Parameters        :
+ *             index : stored index
+ * Return            : index or 'none'
+ * Note              : for internal use
+ ******************************************************************************/
+
+	static unsigned get( Index index_ )
+	{
+		return index_ == static_cast<Index>(none) ? none : index_;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::verify
+ * Description       : check the binary image written by the function 'save'
+ *                     the compiled tables must be packed in order and fill the arena,
+ *                     all stored indices must be in range, the state paths must match the state tree
+ *                     and the chains of guarded actions must be finite
+ * Parameters        :
+ *             image : pointer to the image
+ *              size : size of the image in bytes
+ * Return            : true if the image is valid for this build
+ * Note              : for internal use
+ ******************************************************************************/
+
+	static bool verify( const void *image_, std::size_t size_ )
+	{
+		const Image *header_ = static_cast<const Image *>(image_);
+		if (size_ < sizeof(Image) || reinterpret_cast<std::uintptr_t>(image_) % alignof(std::uint64_t) != 0 ||
+		    std::memcmp(header_->magic, Image::signature, sizeof(header_->magic)) != 0 ||
+		    header_->version != Image::revision || header_->index != sizeof(Index) ||
+		    header_->width <= Event::User - Event::Exit || header_->states >= none || header_->width >= none)
+			return false;
+
+		using Size = std::uint64_t;
+		const Size states_ = header_->states;
+		const Size width_  = header_->width;
+		const Size offset_ = (sizeof(Image) + (width_ - 1) * sizeof(std::uint32_t) + alignof(std::uint64_t) - 1) / alignof(std::uint64_t) * alignof(std::uint64_t);
+		const Size length_ = header_->length;
+
+		// tables are packed in order: nodes, links, lut, columns, tree, sections, origins, history, timers
+		const Size nodes_size_    = Size{header_->links};
+		const Size links_size_    = Size{header_->lut} - header_->links;
+		const Size lut_size_      = Size{header_->columns} - header_->lut;
+		const Size columns_size_  = Size{header_->tree} - header_->columns;
+		const Size tree_size_     = Size{header_->sections} - header_->tree;
+		const Size sections_size_ = Size{header_->origins} - header_->sections;
+		const Size origins_size_  = Size{header_->history} - header_->origins;
+		const Size history_size_  = Size{header_->timers} - header_->history;
+		const Size timers_size_   = length_ - header_->timers;
+
+		if (Size{size_} < offset_ + length_ * sizeof(Index) ||
+		    header_->lut < header_->links || header_->columns < header_->lut || header_->tree < header_->columns ||
+		    header_->sections < header_->tree || header_->origins < header_->sections || header_->history < header_->origins ||
+		    header_->timers < header_->history || length_ < header_->timers ||
+		    nodes_size_ != states_ * NodeSize || links_size_ % LinkSize != 0 || links_size_ / LinkSize >= none ||
+		    lut_size_ != states_ * width_ || columns_size_ != header_->range ||
+		    sections_size_ != (origins_size_ > 0 ? states_ * SectionSize : 0) ||
+		    origins_size_ != (sections_size_ > 0 ? Size{header_->regions} + 1 : 0) || (origins_size_ == 0 && header_->regions != 0) ||
+		    history_size_ != (header_->memories > 0 ? states_ * MemorySize : 0) ||
+		    timers_size_ != Size{header_->timeouts} * TimerSize)
+			return false;
+
+		const unsigned *values_ = reinterpret_cast<const unsigned *>(header_ + 1);
+		const Index *nodes_ = reinterpret_cast<const Index *>(static_cast<const char *>(image_) + offset_);
+		const Index *links_ = nodes_ + header_->links;
+		const Index *lut_ = nodes_ + header_->lut;
+		const Index *columns_ = nodes_ + header_->columns;
+		const Index *tree_ = nodes_ + header_->tree;
+		const Index *sections_ = nodes_ + header_->sections;
+		const Index *origins_ = nodes_ + header_->origins;
+		const Index *history_ = nodes_ + header_->history;
+		const Index *timers_ = nodes_ + header_->timers;
+		const Size actions_ = links_size_ / LinkSize;
+
+		auto below_ = []( Index index_, Size limit_ ){ return Definition::get(index_) == none || Definition::get(index_) < limit_; };
+
+		if (values_[0] != Event::Exit || values_[1] != Event::Entry || values_[2] != Event::Init ||
+		    !std::is_sorted(values_, values_ + width_ - 1, []( unsigned a_, unsigned b_ ){ return a_ <= b_; }))
+			return false;
+
+		for (unsigned state_ = 0; state_ < states_; state_++)
+		{
+			const Index *node_ = &nodes_[state_ * NodeSize];
+			const unsigned parent_ = Definition::get(node_[Parent]);
+			const Size level_ = node_[Level];
+			const Size path_ = node_[Path];
+
+			// parents precede children, the path of the state extends the path of its parent
+			if ((parent_ != none && parent_ >= state_) || level_ != (parent_ != none ? Size{nodes_[parent_ * NodeSize + Level]} + 1 : 1) ||
+			    path_ + level_ > tree_size_ || Definition::get(tree_[path_ + level_ - 1]) != state_ ||
+			    (parent_ != none && !std::equal(&tree_[path_], &tree_[path_ + level_ - 1], &tree_[nodes_[parent_ * NodeSize + Path]])))
+				return false;
+		}
+
+		for (Size action_ = 0; action_ < actions_; action_++)
+		{
+			const Index *link_ = &links_[action_ * LinkSize];
+			if (Definition::get(link_[Owner]) >= states_ || !below_(link_[Target], states_) || !below_(link_[Root], states_) ||
+			    !below_(link_[Slot], header_->handlers) || !below_(link_[Check], header_->guards) || !below_(link_[Next], actions_))
+				return false;
+		}
+
+		for (Size action_ = 0; action_ < actions_; action_++)
+		{
+			Size chain_ = 0;
+			for (unsigned next_ = Definition::get(links_[action_ * LinkSize + Next]); next_ != none; next_ = Definition::get(links_[next_ * LinkSize + Next]))
+				if (++chain_ > actions_)
+					return false;
+		}
+
+		if (!std::all_of(lut_, lut_ + lut_size_, [&]( Index index_ ){ return below_(index_, actions_); }) ||
+		    !std::all_of(columns_, columns_ + columns_size_, [&]( Index index_ ){ return Definition::get(index_) < width_; }) ||
+		    !std::all_of(origins_, origins_ + origins_size_, [&]( Index index_ ){ return below_(index_, states_); }))
+			return false;
+
+		for (Size state_ = 0; state_ < states_ && sections_size_ > 0; state_++)
+		{
+			const Index *section_ = &sections_[state_ * SectionSize];
+			if (Definition::get(section_[Region]) >= origins_size_ || !below_(section_[Branch], origins_size_ + 1) || !below_(section_[Bound], origins_size_ + 1))
+				return false;
+		}
+
+		for (Size state_ = 0; state_ < states_ && history_size_ > 0; state_++)
+		{
+			const Index *memory_ = &history_[state_ * MemorySize];
+			if (!below_(memory_[Memory], header_->memories) || !below_(memory_[Mode], 2))
+				return false;
+		}
+
+		for (Size timer_ = 0; timer_ < header_->timeouts; timer_++)
+		{
+			const Index *item_ = &timers_[timer_ * TimerSize];
+			if (Definition::get(item_[Scope]) >= states_ || Definition::get(item_[Column]) >= width_ || Definition::get(item_[Delay]) == 0)
+				return false;
+		}
+
+		return true;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::order
+ * Description       : stable in-place insertion sort of the compiled table
+ *                     (std::stable_sort may allocate the temporary buffer)
+ * Parameters        :
+ *             table : compiled table
+ *              less : comparison function
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	template<class C>
+	static void order( std::pmr::vector<unsigned>& table_, C less_ )
+	{
+		for (std::size_t item_ = 1; item_ < table_.size(); item_++)
+		{
+			const unsigned value_ = table_[item_];
+			std::size_t hole_ = item_;
+			for (; hole_ > 0 && less_(value_, table_[hole_ - 1]); hole_--)
+				table_[hole_] = table_[hole_ - 1];
+			table_[hole_] = value_;
+		}
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::pack
+ * Description       : append the compiled table to the arena
+ * Parameters        :
+ *             table : compiled table
+ * Return            : pointer to the table in the arena
+ * Note              : for internal use; the arena must have reserved enough space
+ ******************************************************************************/
+
+	Index* pack( const std::pmr::vector<unsigned>& table_ )
+	{
+		assert(Definition::data.size() + table_.size() <= Definition::data.capacity());
+
+		std::size_t offset_ = Definition::data.size();
+		for (unsigned value_: table_)
+			Definition::data.push_back(Definition::put(value_));
+
+		return Definition::data.data() + offset_;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::insert
+ * Description       : insert hsm state with all its ancestors to the set of states
+ * Parameters        :
+ *             state : pointer to hsm state
+ *          inserted : hash set of the states already inserted
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void insert( const State *state_, std::pmr::unordered_set<const State *>& inserted_ )
+	{
+		if (state_ == nullptr || !inserted_.insert(state_).second)
+			return;
+
+		Definition::insert(state_->parent, inserted_);
+		Definition::states.push_back(state_);
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::find
+ * Description       : find index of the given hsm state
+ * Parameters        :
+ *             state : pointer to hsm state
+ * Return            : hsm state index or 'none' if the state is not used by the hsm
+ * Note              : for internal use
+ ******************************************************************************/
+
+	unsigned find( const State *state_ ) const
+	{
+		auto item_ = std::lower_bound(std::begin(Definition::index), std::end(Definition::index), std::make_pair(state_, 0U));
+
+		if (item_ == std::end(Definition::index) || item_->first != state_)
+			return none;
+
+		return item_->second;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::getColumn
+ * Description       : get dispatch table column assigned to the given event value
+ * Parameters        :
+ *             event : event value
+ * Return            : dispatch table column
+ * Note              : for internal use
+ ******************************************************************************/
+
+	unsigned getColumn( unsigned event_ ) const
+	{
+		if (event_ < Definition::range)
+			return Definition::columns[event_];
+
+		if (Definition::range == 0)
+		{
+			const unsigned *last_ = Definition::values + Definition::width - 1;
+			const unsigned *item_ = std::lower_bound(Definition::values, last_, event_);
+			if (item_ != last_ && *item_ == event_)
+				return static_cast<unsigned>(item_ - Definition::values);
+		}
+
+		return Definition::width - 1;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::getColumn
+ * Description       : get dispatch table column assigned to the given event value
+ *                     using the given dense map during compilation
+ * Parameters        :
+ *             event : event value
+ *           columns : dense map of event value to dispatch table column
+ * Return            : dispatch table column
+ * Note              : for internal use
+ ******************************************************************************/
+
+	unsigned getColumn( unsigned event_, const std::pmr::vector<unsigned>& columns_ ) const
+	{
+		if (event_ < columns_.size())
+			return columns_[event_];
+
+		auto item_ = std::lower_bound(std::begin(Definition::events), std::end(Definition::events), event_);
+		if (item_ != std::end(Definition::events) && *item_ == event_)
+			return static_cast<unsigned>(item_ - std::begin(Definition::events));
+
+		return Definition::width - 1;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::getAction
+ * Description       : get action handling the event assigned to the given dispatch table column
+ *                     system events are handled by the state only,
+ *                     user events are handled by the state or its nearest ancestor
+ * Parameters        :
+ *             state : index of state receiving the message
+ *            column : dispatch table column
+ * Return            : index of the handling action or 'none'
+ * Note              : for internal use
+ ******************************************************************************/
+
+	unsigned getAction( unsigned state_, unsigned column_ ) const
+	{
+		if (state_ == none)
+			return none;
+
+		return Definition::get(Definition::lut[state_ * Definition::width + column_]);
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::resolve
+ * Description       : evaluate the guards of the chained actions
+ * Parameters        :
+ *            action : index of the first action handling the event
+ *           message : received message
+ * Return            : index of the first action without guard or with passing guard, or 'none'
+ * Note              : for internal use
+ ******************************************************************************/
+
+	unsigned resolve( unsigned action_, const Message& message_ ) const
+	{
+		while (action_ != none)
+		{
+			Index guard_ = Definition::links[action_ * LinkSize + Check];
+			if (guard_ == static_cast<Index>(none) || Definition::checks[guard_](message_))
+				break;
+
+			action_ = Definition::get(Definition::links[action_ * LinkSize + Next]);
+		}
+
+		return action_;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::isGuarded
+ * Description       : check if the action has the guard
+ * Parameters        :
+ *            action : action index
+ * Return            : true if the action is the guarded direct transition
+ * Note              : for internal use
+ ******************************************************************************/
+
+	bool isGuarded( unsigned action_ ) const
+	{
+		return Definition::links[action_ * LinkSize + Check] != static_cast<Index>(none);
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::getChain
+ * Description       : get the next action of the collapsed chain of pure Init transitions
+ * Parameters        :
+ *            action : action index
+ * Return            : index of the Init action of the state entered by the chain or 'none'
+ * Note              : for internal use; the chain is followed by the trace only
+ ******************************************************************************/
+
+	unsigned getChain( unsigned action_ ) const
+	{
+		return Definition::isGuarded(action_) ? none : Definition::get(Definition::links[action_ * LinkSize + Next]);
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::isDeferred
+ * Description       : check if the action defers the event
+ * Parameters        :
+ *            action : action index
+ * Return            : true if the action has neither the transition target nor the event handler
+ * Note              : for internal use
+ ******************************************************************************/
+
+	bool isDeferred( unsigned action_ ) const
+	{
+		const Index *link_ = &Definition::links[action_ * LinkSize];
+
+		return link_[Target] == static_cast<Index>(none) && link_[Slot] == static_cast<Index>(none);
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::getActions
+ * Description       : get the number of compiled actions
+ * Parameters        : none
+ * Return            : number of compiled actions
+ * Note              : for internal use; compiled actions precede the dispatch tables in the arena
+ ******************************************************************************/
+
+	unsigned getActions() const
+	{
+		return static_cast<unsigned>((Definition::lut - Definition::links) / LinkSize);
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::getLink
+ * Description       : get the compiled action
+ * Parameters        :
+ *            action : action index
+ * Return            : owner, direct transition target and root state of the action
+ * Note              : for internal use
+ ******************************************************************************/
+
+	Link getLink( unsigned action_ ) const
+	{
+		const Index *link_ = &Definition::links[action_ * LinkSize];
+
+		return { Definition::get(link_[Owner]), Definition::get(link_[Target]), Definition::get(link_[Root]) };
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::callHandler
+ * Description       : invoke event handler assigned to the action, if such a variant exists
+ * Parameters        :
+ *            action : action index
+ *           message : received message
+ * Return            : true if the event handler has been invoked
+ * Note              : for internal use
+ ******************************************************************************/
+
+	bool callHandler( unsigned action_, const Message& message_ ) const
+	{
+		Index slot_ = Definition::links[action_ * LinkSize + Slot];
+
+		if (slot_ == static_cast<Index>(none))
+			return false;
+
+		(*Definition::slots[slot_])(message_);
+		return true;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::getLevel
+ * Description       : get state level in the hsm state tree
+ * Parameters        :
+ *             state : hsm state index
+ * Return            : state level for given hsm state
+ * Note              : for internal use
+ ******************************************************************************/
+
+	unsigned getLevel( unsigned state_ ) const
+	{
+		if (state_ == none)
+			return 0;
+
+		return Definition::nodes[state_ * NodeSize + Level];
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::getRoot
+ * Description       : get root state for hsm state and the other
+ * Parameters        :
+ *             state : hsm state index
+ *             other : the other hsm state index
+ * Return            : root state index
+ * Note              : for internal use
+ ******************************************************************************/
+
+	unsigned getRoot( unsigned state_, unsigned other_ ) const
+	{
+		unsigned lo_ = 0;
+		unsigned hi_ = std::min(Definition::getLevel(state_), Definition::getLevel(other_));
+
+		const Index *state_path_ = hi_ > 0 ? &Definition::tree[Definition::nodes[state_ * NodeSize + Path]] : nullptr;
+		const Index *other_path_ = hi_ > 0 ? &Definition::tree[Definition::nodes[other_ * NodeSize + Path]] : nullptr;
+
+		while (lo_ < hi_) // paths are equal up to the root level
+		{
+			unsigned level_ = (lo_ + hi_ + 1) / 2;
+			if (state_path_[level_ - 1] == other_path_[level_ - 1])
+				lo_ = level_;
+			else
+				hi_ = level_ - 1;
+		}
+
+		return lo_ > 0 ? Definition::get(state_path_[lo_ - 1]) : none;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::getPrev
+ * Description       : get the parent of the hsm state
+ * Parameters        :
+ *             state : hsm state index
+ * Return            : parent state index
+ * Note              : for internal use
+ ******************************************************************************/
+
+	unsigned getPrev( unsigned state_ ) const
+	{
+		if (state_ == none)
+			return none;
+
+		return Definition::get(Definition::nodes[state_ * NodeSize + Parent]);
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::getNext
+ * Description       : get child state in the child branch
+ * Parameters        :
+ *             state : hsm state index
+ *              sign : index of the hsm state in the child branch
+ * Return            : child state index
+ * Note              : for internal use
+ ******************************************************************************/
+
+	unsigned getNext( unsigned state_, unsigned sign_ ) const
+	{
+		return Definition::tree[Definition::nodes[sign_ * NodeSize + Path] + Definition::getLevel(state_)];
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::getRegion
+ * Description       : get the orthogonal region of the hsm state
+ * Parameters        :
+ *             state : hsm state index
+ * Return            : index of the nearest region containing the state (0 for the whole hsm)
+ * Note              : for internal use; the hsm must have orthogonal regions
+ ******************************************************************************/
+
+	unsigned getRegion( unsigned state_ ) const
+	{
+		if (state_ == none)
+			return 0;
+
+		return Definition::get(Definition::sections[state_ * SectionSize + Region]);
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::getBranch
+ * Description       : get the first orthogonal region of the parallel state
+ * Parameters        :
+ *             state : hsm state index
+ * Return            : index of the first region or 'none' if the state is not parallel
+ * Note              : for internal use; the hsm must have orthogonal regions
+ ******************************************************************************/
+
+	unsigned getBranch( unsigned state_ ) const
+	{
+		if (state_ == none)
+			return none;
+
+		return Definition::get(Definition::sections[state_ * SectionSize + Branch]);
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::getBound
+ * Description       : get the index past the last orthogonal region of the parallel state
+ * Parameters        :
+ *             state : hsm state index
+ * Return            : index past the last region
+ * Note              : for internal use; the state must be parallel
+ ******************************************************************************/
+
+	unsigned getBound( unsigned state_ ) const
+	{
+		return Definition::get(Definition::sections[state_ * SectionSize + Bound]);
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::getTimer
+ * Description       : get the first state timeout of the hsm state
+ * Parameters        :
+ *             state : hsm state index
+ * Return            : index of the first timeout owned by the state or by the next states
+ * Note              : for internal use
+ ******************************************************************************/
+
+	unsigned getTimer( unsigned state_ ) const
+	{
+		unsigned lo_ = 0;
+		unsigned hi_ = Definition::timeouts;
+
+		while (lo_ < hi_)
+		{
+			unsigned timer_ = (lo_ + hi_) / 2;
+			if (Definition::get(Definition::timers[timer_ * TimerSize + Scope]) < state_)
+				lo_ = timer_ + 1;
+			else
+				hi_ = timer_;
+		}
+
+		return lo_;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::ownsTimer
+ * Description       : check if the state timeout is owned by the hsm state
+ * Parameters        :
+ *             timer : state timeout index
+ *             state : hsm state index
+ * Return            : true if the timeout exists and is owned by the state
+ * Note              : for internal use
+ ******************************************************************************/
+
+	bool ownsTimer( unsigned timer_, unsigned state_ ) const
+	{
+		return timer_ < Definition::timeouts && Definition::get(Definition::timers[timer_ * TimerSize + Scope]) == state_;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::getDelay
+ * Description       : get the delay of the state timeout
+ * Parameters        :
+ *             timer : state timeout index
+ * Return            : delay in ticks of the timer wheel
+ * Note              : for internal use
+ ******************************************************************************/
+
+	unsigned getDelay( unsigned timer_ ) const
+	{
+		return Definition::timers[timer_ * TimerSize + Delay];
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::getEvent
+ * Description       : get the event value sent by the expired state timeout
+ * Parameters        :
+ *             timer : state timeout index
+ * Return            : event value
+ * Note              : for internal use
+ ******************************************************************************/
+
+	unsigned getEvent( unsigned timer_ ) const
+	{
+		return Definition::values[Definition::timers[timer_ * TimerSize + Column]];
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::getOrigin
+ * Description       : get the root state of the orthogonal region
+ * Parameters        :
+ *            region : region index
+ * Return            : index of the region root state (child of the parallel state)
+ * Note              : for internal use
+ ******************************************************************************/
+
+	unsigned getOrigin( unsigned region_ ) const
+	{
+		return Definition::get(Definition::origins[region_]);
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::getMemory
+ * Description       : get the history slot of the hsm state
+ * Parameters        :
+ *             state : hsm state index
+ * Return            : index of the history slot or 'none' if the state has no history
+ * Note              : for internal use; the hsm must have states with history
+ ******************************************************************************/
+
+	unsigned getMemory( unsigned state_ ) const
+	{
+		if (state_ == none)
+			return none;
+
+		return Definition::get(Definition::history[state_ * MemorySize + Memory]);
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::isDeep
+ * Description       : check if the hsm state has deep history
+ * Parameters        :
+ *             state : hsm state index
+ * Return            : true for deep history, false for shallow history
+ * Note              : for internal use; the state must have history
+ ******************************************************************************/
+
+	bool isDeep( unsigned state_ ) const
+	{
+		return Definition::history[state_ * MemorySize + Mode] != 0;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Definition::contains
+ * Description       : check if the orthogonal region contains the hsm state
+ * Parameters        :
+ *            region : region index
+ *             state : hsm state index
+ * Return            : true if the state is the region root state or its descendant
+ * Note              : for internal use
+ ******************************************************************************/
+
+	bool contains( unsigned region_, unsigned state_ ) const
+	{
+		if (region_ == 0)
+			return true;
+
+		unsigned origin_ = Definition::getOrigin(region_);
+		unsigned level_ = Definition::getLevel(origin_);
+
+		return Definition::getLevel(state_) >= level_ &&
+		       Definition::get(Definition::tree[Definition::nodes[state_ * NodeSize + Path] + level_ - 1]) == origin_;
+	}
+
+	friend struct StateMachine;
+	friend struct StateMachineArray;
+	friend struct LiveDefinition;
+	friend struct Profile;
+};
+
+/******************************************************************************
+ *
+ * Class             : Queue
+ *
+ * Description       : bounded ring buffer of hsm messages
+ *                     used by hsm instance for run-to-completion message handling
+ *                     storage is provided by the derived class (MessageQueue)
+ *
+ * Constructor parameters
+ *              data : pointer to the storage of messages
+ *          capacity : number of messages in the storage
+ *
+ ******************************************************************************/
+
+struct Queue
+{
+	Queue( Message *data_, std::size_t capacity_ ): data{data_}, capacity{capacity_} {}
+
+	Queue( Queue&& ) = delete;
+	Queue( const Queue& ) = delete;
+	Queue& operator=( Queue&& ) = delete;
+	Queue& operator=( const Queue& ) = delete;
+
+/******************************************************************************
+ * Name              : hsm::Queue::push
+ * Description       : put message at the end of the queue
+ * Parameters        :
+ *               msg : message
+ * Return            : false if the queue is full
+ ******************************************************************************/
+
+	bool push( const Message& message_ )
+	{
+		if (Queue::count == Queue::capacity)
+			return false;
+
+		std::size_t tail_ = Queue::head + Queue::count++;
+		Queue::data[tail_ < Queue::capacity ? tail_ : tail_ - Queue::capacity] = message_;
+
+		return true;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Queue::pop
+ * Description       : get message from the front of the queue
+ * Parameters        :
+ *               msg : received message
+ * Return            : false if the queue is empty
+ ******************************************************************************/
+
+	bool pop( Message& message_ )
+	{
+		if (Queue::count == 0)
+			return false;
+
+		message_ = Queue::data[Queue::head];
+		if (++Queue::head == Queue::capacity)
+			Queue::head = 0;
+		Queue::count--;
+
+		return true;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Queue::size
+ * Description       : get number of messages in the queue
+ * Parameters        : none
+ * Return            : number of messages in the queue
+ ******************************************************************************/
+
+	std::size_t size() const
+	{
+		return Queue::count;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Queue::clear
+ * Description       : remove all messages from the queue
+ * Parameters        : none
+ * Return            : none
+ ******************************************************************************/
+
+	void clear()
+	{
+		Queue::head = 0;
+		Queue::count = 0;
+	}
+
+/* -------------------------------------------------------------------------- */
+
+	private:
+	Message *data;         // storage of messages
+	std::size_t capacity;  // number of messages in the storage
+	std::size_t head{};    // position of the first message
+	std::size_t count{};   // number of messages in the queue
+	bool busy{};           // the hsm instance is handling the message
+	bool again{};          // the transition during the replay of deferred messages requires the next pass
+
+	friend struct StateMachine;
+};
+
+/******************************************************************************
+ *
+ * Class             : MessageQueue
+ *
+ * Description       : bounded ring buffer of hsm messages with static storage
+ *
+ * Template parameters
+ *                 N : capacity of the queue
+ *
+ ******************************************************************************/
+
+template<std::size_t N>
+struct MessageQueue : Queue
+{
+	MessageQueue(): Queue{MessageQueue::buffer, N} {}
+
+	private:
+	Message buffer[N]; // storage of messages
+};
+
+/******************************************************************************
+ *
+ * Class             : LiveDefinition
+ *
+ * Description       : versioned hsm definition patched at runtime
+ *                     each published revision is compiled aside and then swapped in atomically;
+ *                     hsm instances following the live definition switch to the current revision
+ *                     at their next run-to-completion boundary, keeping their configuration
+ *                     (current states, history) mapped by the state objects
+ *                     retired revisions are released when no hsm instance runs them any more (RCU)
+ *                     the revisions are published from one thread at a time,
+ *                     hsm instances never take a lock
+ *
+ * Constructor parameters
+ *               tab : set of hsm actions of the first revision
+ *          resource : memory resource providing all storage of the revisions
+ *                     (default: hsm::defaultResource())
+ *
+ ******************************************************************************/
+
+struct LiveDefinition
+{
+	explicit LiveDefinition( std::pmr::memory_resource *resource_ = defaultResource() ): resource{resource_} {}
+	LiveDefinition( const Table& tab_, std::pmr::memory_resource *resource_ = defaultResource() ):
+		LiveDefinition(resource_) { LiveDefinition::publish(tab_); }
+
+	LiveDefinition( LiveDefinition&& ) = delete;
+	LiveDefinition( const LiveDefinition& ) = delete;
+	LiveDefinition& operator=( LiveDefinition&& ) = delete;
+	LiveDefinition& operator=( const LiveDefinition& ) = delete;
+
+	~LiveDefinition()
+	{
+		Revision *revision_ = LiveDefinition::head.exchange(nullptr);
+		if (revision_ != nullptr)
+			LiveDefinition::retire(revision_);
+		[[maybe_unused]] std::size_t retained_ = LiveDefinition::reclaim();
+		assert(retained_ == 0); // all hsm instances following the live definition must be destroyed first
+	}
+
+/******************************************************************************
+ * Name              : hsm::LiveDefinition::publish
+ * Description       : publish the new revision built from the given set of hsm actions
+ * Parameters        :
+ *               tab : set of hsm actions
+ * Return            : version of the published revision
+ ******************************************************************************/
+
+	unsigned publish( const Table& tab_ )
+	{
+		Revision *revision_ = LiveDefinition::create();
+		revision_->def.add(tab_);
+
+		return LiveDefinition::swap(revision_);
+	}
+
+/******************************************************************************
+ * Name              : hsm::LiveDefinition::patch
+ * Description       : publish the new revision built from the current one patched with the given set of hsm actions
+ *                     the action replaces the action of the current revision with the same owner state,
+ *                     event value and guard (the state timeout replaces the state timeout); other actions are added
+ * Parameters        :
+ *               tab : set of hsm actions
+ * Return            : version of the published revision
+ ******************************************************************************/
+
+	unsigned patch( const Table& tab_ )
+	{
+		Revision *revision_ = LiveDefinition::create();
+		const Revision *current_ = LiveDefinition::head.load(std::memory_order_relaxed);
+
+		if (current_ != nullptr)
+		{
+			auto replaced_ = [&tab_]( const Action& action_ ){
+				return std::any_of(std::begin(tab_), std::end(tab_), [&action_]( const Action& other_ ){
+					return &other_.owner == &action_.owner && other_.event == action_.event &&
+					       other_.guard == action_.guard && (other_.delay != 0) == (action_.delay != 0); }); };
+
+			revision_->def.tab.reserve(current_->def.tab.size() + tab_.size());
+			for (const Action& action_: current_->def.tab)
+				if (!replaced_(action_))
+					revision_->def.tab.push_back(action_);
+			revision_->def.extra.assign(std::begin(current_->def.extra), std::end(current_->def.extra));
+		}
+		revision_->def.add(tab_);
+
+		return LiveDefinition::swap(revision_);
+	}
+
+/******************************************************************************
+ * Name              : hsm::LiveDefinition::version
+ * Description       : get the version of the current revision
+ * Parameters        : none
+ * Return            : version of the current revision (0 if nothing has been published)
+ ******************************************************************************/
+
+	unsigned version() const
+	{
+		const Revision *revision_ = LiveDefinition::head.load(std::memory_order_acquire);
+
+		return revision_ != nullptr ? revision_->version : 0;
+	}
+
+/******************************************************************************
+ * Name              : hsm::LiveDefinition::reclaim
+ * Description       : release retired revisions not run by any hsm instance
+ *                     called by the functions 'publish' and 'patch'
+ * Parameters        : none
+ * Return            : number of retired revisions still run by hsm instances
+ ******************************************************************************/
+
+	std::size_t reclaim()
+	{
+		// the hsm instance which has not finished 'acquire' may still bind any retired revision
+		if (LiveDefinition::entering.load() != 0)
+			return LiveDefinition::retained;
+
+		for (Revision **item_ = &(LiveDefinition::retired); *item_ != nullptr;)
+		{
+			Revision *revision_ = *item_;
+			if (revision_->users.load(std::memory_order_acquire) != 0)
+			{
+				item_ = &revision_->next;
+				continue;
+			}
+
+			*item_ = revision_->next;
+			revision_->~Revision();
+			LiveDefinition::resource->deallocate(revision_, sizeof(Revision), alignof(Revision));
+			LiveDefinition::retained--;
+		}
+
+		return LiveDefinition::retained;
+	}
+
+/* -------------------------------------------------------------------------- */
+
+	private:
+	struct Revision
+	{
+		explicit Revision( std::pmr::memory_resource *resource_ ): def{resource_} {}
+
+		Definition def;                     // compiled definition of the revision
+		std::atomic<std::size_t> users{};   // number of hsm instances running the revision
+		Revision *next{};                   // next retired revision
+		unsigned version{};                 // version of the revision
+	};
+
+	std::atomic<Revision *> head{};         // current revision
+	std::atomic<std::size_t> entering{};    // number of hsm instances acquiring the current revision
+	Revision *retired{};                    // list of retired revisions
+	std::size_t retained{};                 // number of retired revisions
+	unsigned number{};                      // version of the last published revision
+	std::pmr::memory_resource *resource;    // memory resource of the revisions
+
+/******************************************************************************
+ * Name              : hsm::LiveDefinition::create
+ * Description       : create the empty revision in the memory resource of the live definition
+ * Parameters        : none
+ * Return            : pointer to the revision
+ * Note              : for internal use
+ ******************************************************************************/
+
+	Revision* create()
+	{
+		return ::new (LiveDefinition::resource->allocate(sizeof(Revision), alignof(Revision))) Revision{LiveDefinition::resource};
+	}
+
+/******************************************************************************
+ * Name              : hsm::LiveDefinition::swap
+ * Description       : compile the revision and make it current, retire the previous one
+ * Parameters        :
+ *          revision : pointer to the new revision
+ * Return            : version of the new revision
+ * Note              : for internal use
+ ******************************************************************************/
+
+	unsigned swap( Revision *revision_ )
+	{
+		revision_->def.compile();
+		revision_->version = ++LiveDefinition::number;
+
+		Revision *previous_ = LiveDefinition::head.exchange(revision_);
+		if (previous_ != nullptr)
+			LiveDefinition::retire(previous_);
+		LiveDefinition::reclaim();
+
+		return revision_->version;
+	}
+
+/******************************************************************************
+ * Name              : hsm::LiveDefinition::retire
+ * Description       : put the revision to the list of retired revisions
+ * Parameters        :
+ *          revision : pointer to the revision
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void retire( Revision *revision_ )
+	{
+		revision_->next = LiveDefinition::retired;
+		LiveDefinition::retired = revision_;
+		LiveDefinition::retained++;
+	}
+
+/******************************************************************************
+ * Name              : hsm::LiveDefinition::acquire
+ * Description       : bind the current revision to the hsm instance
+ * Parameters        : none
+ * Return            : pointer to the current revision
+ * Note              : for internal use
+ ******************************************************************************/
+
+	Revision* acquire()
+	{
+		LiveDefinition::entering.fetch_add(1);
+		Revision *revision_ = LiveDefinition::head.load();
+		assert(revision_ != nullptr); // the first revision must be published
+		revision_->users.fetch_add(1, std::memory_order_relaxed);
+		LiveDefinition::entering.fetch_sub(1, std::memory_order_release);
+
+		return revision_;
+	}
+
+/******************************************************************************
+ * Name              : hsm::LiveDefinition::release
+ * Description       : unbind the revision from the hsm instance
+ * Parameters        :
+ *          revision : pointer to the revision
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	static void release( Revision *revision_ )
+	{
+		revision_->users.fetch_sub(1, std::memory_order_release);
+	}
+
+	friend struct StateMachine;
+};
+
+/******************************************************************************
+ *
+ * Class             : StateMachine
+ *
+ * Description       : hierarchical state machine object
+ *                     lightweight hsm instance running the shared hsm definition
+ *                     or the private definition built with 'add' functions
+ *                     attachments (queues, timer wheel, live definition) and the slots of orthogonal regions
+ *                     and history are kept in the extension allocated on demand from the memory resource of the definition
+ *
+ * Constructor parameters
+ *               def : shared hsm definition
+ *                or
+ *               tab : set of hsm actions for the private definition
+ *          resource : memory resource providing all storage of the private definition
+ *                     (default: hsm::defaultResource())
+ *                or
+ *              live : live definition, the hsm runs its current revision
+ *
+ ******************************************************************************/
+
+struct StateMachine
+{
+	StateMachine():                                  def{}                  {}
+	StateMachine( const Definition& def_ ):          def{&def_}             {}
+	explicit StateMachine( std::pmr::memory_resource *resource_ ): def{StateMachine::create(resource_)} {}
+	StateMachine( const Table& tab_, std::pmr::memory_resource *resource_ = defaultResource() ):
+		def{StateMachine::create(resource_)} { StateMachine::getDefinition()->add(tab_); }
+#ifndef HSM_FREESTANDING
+	StateMachine( Table&& tab_, std::pmr::memory_resource *resource_ = defaultResource() ):
+		def{StateMachine::create(resource_)} { StateMachine::getDefinition()->add(std::move(tab_)); }
+#endif
+	explicit StateMachine( LiveDefinition& live_ ): def{} { StateMachine::follow(live_); }
+
+	StateMachine( StateMachine&& hsm_ ): def{hsm_.def}, state{hsm_.state}, target{hsm_.target}, extension{hsm_.extension}
+	{
+		if (StateMachine::extension != nullptr)
+			for (unsigned timer_: StateMachine::extension->timers)
+				if (timer_ != Definition::none)
+					StateMachine::extension->wheel->rebind(timer_, this);
+#ifdef HSM_METRICS
+		StateMachine::metrics = hsm_.metrics;
+#endif
+		if (StateMachine::def != nullptr && StateMachine::def->owner == &hsm_)
+			const_cast<Definition *>(StateMachine::def)->owner = this;
+		hsm_.def = nullptr;
+		hsm_.extension = nullptr;
+	}
+
+	StateMachine( const StateMachine& ) = delete;
+	StateMachine& operator=( StateMachine&& ) = delete;
+	StateMachine& operator=( const StateMachine& ) = delete;
+
+	~StateMachine()
+	{
+		StateMachine::cancel();
+
+		if (StateMachine::def != nullptr && StateMachine::def->owner == this)
+			StateMachine::destroy(StateMachine::def);
+		if (StateMachine::extension != nullptr)
+			StateMachine::release(StateMachine::extension);
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::add
+ * Description       : add set of hsm actions to the private hsm definition
+ *               tab : set of hsm actions
+ * Return            : none
+ ******************************************************************************/
+
+	void add( const Table& tab_ )
+	{
+		StateMachine::getDefinition()->add(tab_);
+	}
+
+#ifndef HSM_FREESTANDING
+/******************************************************************************
+ * Name              : hsm::StateMachine::add
+ * Description       : move set of hsm actions to the private hsm definition
+ *               tab : set of hsm actions
+ * Return            : none
+ ******************************************************************************/
+
+	void add( Table&& tab_ )
+	{
+		StateMachine::getDefinition()->add(std::move(tab_));
+	}
+#endif
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::add
+ * Description       : add hsm action with given parameters to the private hsm definition
+ * Parameters        :
+ *             owner : hsm action owner (State)
+ *             event : hsm action event value
+ *    handler, state : variant parameter for hsm action constructor
+ * Return            : none
+ * Note              : declared and defined in header file
+ ******************************************************************************/
+
+	template<class T>
+	void add( State& owner_, unsigned event_, T&& action_ )
+	{
+		StateMachine::getDefinition()->add(owner_, event_, std::forward<T>(action_));
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::reserve
+ * Description       : reserve storage for the given number of hsm actions in the private hsm definition
+ * Parameters        :
+ *             count : expected number of hsm actions
+ * Return            : none
+ ******************************************************************************/
+
+	void reserve( std::size_t count_ )
+	{
+		StateMachine::getDefinition()->reserve(count_);
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::start
+ * Description       : start hierarchical state machine
+ * Parameters        :
+ *              init : initial hsm state
+ * Return            : none
+ ******************************************************************************/
+
+	void start( State& init_ )
+	{
+		assert(StateMachine::def != nullptr);
+		assert(StateMachine::state == Definition::none);
+		assert(init_.parent == nullptr);
+		assert(StateMachine::getDeferred() == nullptr || StateMachine::def->regions == 0);
+
+		if (StateMachine::getLive() != nullptr)
+			StateMachine::update();
+
+		if (StateMachine::state == Definition::none)
+		{
+			unsigned next_ = StateMachine::getState(&init_);
+			Queue *queue_ = StateMachine::getQueue();
+
+			if (StateMachine::getDeferred() != nullptr)
+				StateMachine::getDeferred()->clear();
+			if (StateMachine::getWheel() != nullptr && StateMachine::def->timeouts != 0)
+				StateMachine::extension->timers.assign(StateMachine::def->timeouts, Definition::none);
+
+			if (StateMachine::def->regions != 0)
+				StateMachine::extend()->regions.assign(StateMachine::def->regions + 1, Definition::none);
+			if (StateMachine::def->memories != 0)
+				StateMachine::extend()->history.assign(StateMachine::def->memories, Definition::none);
+
+			if (queue_ == nullptr || queue_->busy)
+			{
+				StateMachine::transition(next_, {});
+			}
+			else
+			{
+				queue_->busy = true;
+				StateMachine::transition(next_, {});
+				StateMachine::drain();
+				queue_->busy = false;
+			}
+		}
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::message
+ * Description       : handle given user message
+ *                     the message sent from the event handler (or while the handling is suspended)
+ *                     is queued and handled after the current message
+ * Parameters        :
+ *               msg : message
+ * Return            : false if the message has to be queued and the queue is full (the message is dropped)
+ ******************************************************************************/
+
+	bool message( const Message& message_ )
+	{
+		assert(StateMachine::state != Definition::none);
+		assert(message_.event == Event::Stop || message_.event >= Event::User);
+
+		Queue *queue_ = StateMachine::getQueue();
+
+		if (queue_ == nullptr)
+		{
+			StateMachine::handle(message_);
+		}
+		else
+		if (queue_->busy)
+		{
+			return queue_->push(message_);
+		}
+		else
+		{
+			if (StateMachine::getLive() != nullptr)
+				StateMachine::update();
+
+			queue_->busy = true;
+			StateMachine::handle(message_);
+			StateMachine::drain();
+			queue_->busy = StateMachine::isSuspended();
+		}
+
+		return true;
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::message
+ * Description       : handle given range of user messages in order
+ * Parameters        :
+ *             first : iterator to the first message
+ *              last : iterator past the last message
+ * Return            : false if the message has been dropped, the following messages are not handled
+ * Note              : declared and defined in header file
+ ******************************************************************************/
+
+	template<class I>
+	bool message( I first_, I last_ )
+	{
+		for (; first_ != last_; ++first_)
+			if (!StateMachine::message(*first_))
+				return false;
+
+		return true;
+	}
+
+#if __cplusplus >= 202002L
+/******************************************************************************
+ * Name              : hsm::StateMachine::message
+ * Description       : handle given span of user messages in order
+ * Parameters        :
+ *               tab : span of messages
+ * Return            : false if the message has been dropped, the following messages are not handled
+ ******************************************************************************/
+
+	bool message( std::span<const Message> tab_ )
+	{
+		return StateMachine::message(std::begin(tab_), std::end(tab_));
+	}
+#endif
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::attach
+ * Description       : attach the queue of posted messages to the hsm
+ *                     with the queue attached, messages are handled with run-to-completion
+ *                     semantics: the message sent from the event handler is queued
+ *                     and handled after the current message
+ * Parameters        :
+ *             queue : queue of messages (MessageQueue)
+ * Return            : none
+ ******************************************************************************/
+
+	void attach( Queue& queue_ )
+	{
+		assert(StateMachine::getQueue() == nullptr || !StateMachine::getQueue()->busy);
+
+		StateMachine::extend()->queue = &queue_;
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::defer
+ * Description       : attach the queue of deferred messages to the hsm
+ *                     the user event resolved to the Defer action is kept in the queue
+ *                     and replayed in order after each transition; the message deferred
+ *                     again in the new state is kept in the queue, others are handled
+ *                     the deferred message borrows its payload (HSM_PAYLOAD) until it's replayed
+ *                     the message that doesn't fit in the full queue is passed to the outer states
+ * Parameters        :
+ *             queue : queue of deferred messages (MessageQueue), its capacity limits the number of deferred messages
+ * Return            : none
+ * Note              : the hsm with orthogonal regions cannot defer events
+ ******************************************************************************/
+
+	void defer( Queue& queue_ )
+	{
+		assert(StateMachine::getDeferred() == nullptr || !StateMachine::getDeferred()->busy);
+
+		StateMachine::extend()->deferred = &queue_;
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::attach
+ * Description       : attach the timer wheel of state timeouts to the hsm
+ *                     the timers of state timeouts are armed on entry to the owner state
+ *                     and disarmed on exit; the expired timer sends its user event to the hsm
+ *                     the wheel can be shared by any number of hsm instances
+ * Parameters        :
+ *             wheel : timer wheel (TimerWheel), its capacity limits the number of armed timeouts
+ * Return            : none
+ * Note              : the hsm must be stopped
+ ******************************************************************************/
+
+	void attach( TimerWheel& wheel_ )
+	{
+		assert(StateMachine::state == Definition::none);
+
+		StateMachine::extend()->wheel = &wheel_;
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::save
+ * Description       : get the snapshot of the hsm: index of the current state in the hsm definition
+ *                     the snapshot can be restored by any hsm instance running
+ *                     a definition compiled from the same action table
+ * Parameters        : none
+ * Return            : index of the current state or 'Definition::none' if the hsm is stopped
+ * Note              : the definition must not have orthogonal regions and states with history
+ ******************************************************************************/
+
+	unsigned save() const
+	{
+		assert(StateMachine::def == nullptr || (StateMachine::def->regions == 0 && StateMachine::def->memories == 0));
+
+		return StateMachine::state;
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::save
+ * Description       : get the full snapshot of the hsm: index of the current state,
+ *                     current states of all orthogonal regions and states remembered by all states with history
+ *                     the snapshot can be restored by any hsm instance running
+ *                     a definition compiled from the same action table
+ * Parameters        :
+ *               tab : array for the snapshot or nullptr
+ * Return            : number of entries of the snapshot
+ ******************************************************************************/
+
+	std::size_t save( unsigned *tab_ ) const
+	{
+		if (StateMachine::def == nullptr)
+			return 0;
+
+		const std::size_t regions_ = StateMachine::def->regions;
+		const std::size_t memories_ = StateMachine::def->memories;
+
+		if (tab_ != nullptr)
+		{
+			assert(StateMachine::extension == nullptr || StateMachine::extension->region == 0);
+
+			tab_[0] = StateMachine::state;
+			if (StateMachine::extension != nullptr && StateMachine::extension->regions.size() == regions_ + 1)
+				std::copy_n(StateMachine::extension->regions.data() + 1, regions_, tab_ + 1);
+			else
+				std::fill_n(tab_ + 1, regions_, Definition::none);
+			if (StateMachine::extension != nullptr && StateMachine::extension->history.size() == memories_)
+				std::copy_n(StateMachine::extension->history.data(), memories_, tab_ + 1 + regions_);
+			else
+				std::fill_n(tab_ + 1 + regions_, memories_, Definition::none);
+		}
+
+		return 1 + regions_ + memories_;
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::restore
+ * Description       : set the current state of the stopped hsm from the snapshot
+ *                     no event handlers (Entry, Init) are called
+ * Parameters        :
+ *             state : index of the current state returned by the function 'save'
+ * Return            : none
+ * Note              : the definition must not have orthogonal regions and states with history
+ ******************************************************************************/
+
+	void restore( unsigned state_ )
+	{
+		assert(StateMachine::def != nullptr);
+
+		if (StateMachine::def->owner == this && !StateMachine::def->ready)
+			StateMachine::compile();
+
+		assert(StateMachine::def->regions == 0 && StateMachine::def->memories == 0);
+
+		StateMachine::restore(&state_);
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::restore
+ * Description       : set the current configuration of the stopped hsm from the full snapshot
+ *                     no event handlers (Entry, Init) are called
+ * Parameters        :
+ *               tab : snapshot written by the function 'save'
+ * Return            : none
+ * Note              : with performance counters attached, the restored states are counted as entered
+ *                     with the timer wheel attached, timeouts of the restored states are armed
+ ******************************************************************************/
+
+	void restore( const unsigned *tab_ )
+	{
+		assert(StateMachine::def != nullptr);
+		assert(StateMachine::state == Definition::none);
+
+		if (StateMachine::def->owner == this && !StateMachine::def->ready)
+			StateMachine::compile();
+
+		assert(StateMachine::def->ready);
+
+		const std::size_t regions_ = StateMachine::def->regions;
+		const std::size_t memories_ = StateMachine::def->memories;
+
+		for (std::size_t item_ = 0; item_ < 1 + regions_ + memories_; item_++)
+			assert(tab_[item_] == Definition::none || tab_[item_] < StateMachine::def->states.size());
+
+		StateMachine::state = tab_[0];
+		if (regions_ != 0)
+			StateMachine::extend()->regions.assign(tab_, tab_ + 1 + regions_);
+		if (memories_ != 0)
+			StateMachine::extend()->history.assign(tab_ + 1 + regions_, tab_ + 1 + regions_ + memories_);
+		if (StateMachine::getWheel() != nullptr && StateMachine::def->timeouts != 0)
+			StateMachine::extension->timers.assign(StateMachine::def->timeouts, Definition::none);
+#ifdef HSM_METRICS
+		std::uint64_t time_ = StateMachine::metrics != nullptr ? HSM_METRICS_CLOCK() : 0;
+#endif
+		for (std::size_t region_ = 0; region_ <= regions_; region_++)
+		{
+			unsigned active_ = region_ == 0 ? StateMachine::state : StateMachine::extension->regions[region_];
+			unsigned bound_ = region_ == 0 ? Definition::none : StateMachine::def->getPrev(StateMachine::def->getOrigin(static_cast<unsigned>(region_)));
+			for (; active_ != Definition::none && active_ != bound_; active_ = StateMachine::def->getPrev(active_))
+			{
+#ifdef HSM_METRICS
+				if (StateMachine::metrics != nullptr)
+					StateMachine::metrics->entry(active_, time_, 0);
+#endif
+				if (StateMachine::isScheduled())
+					StateMachine::schedule(active_, true);
+			}
+		}
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::restore
+ * Description       : set the current state of the stopped hsm
+ *                     no event handlers (Entry, Init) are called
+ * Parameters        :
+ *             state : hsm state
+ * Return            : none
+ ******************************************************************************/
+
+	void restore( State& state_ )
+	{
+		assert(StateMachine::def != nullptr);
+
+		StateMachine::restore(StateMachine::getState(&state_));
+	}
+
+#ifdef HSM_METRICS
+/******************************************************************************
+ * Name              : hsm::StateMachine::attach
+ * Description       : attach the performance counters to the hsm
+ *                     the counters can be shared by hsm instances running the same definition
+ * Parameters        :
+ *           metrics : performance counters (Metrics)
+ * Return            : none
+ * Note              : available with HSM_METRICS defined
+ ******************************************************************************/
+
+	void attach( Metrics& metrics_ )
+	{
+		StateMachine::metrics = &metrics_;
+
+		if (StateMachine::def != nullptr && StateMachine::def->ready)
+			metrics_.resize(StateMachine::def->states.size(), StateMachine::def->width);
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::snapshot
+ * Description       : get the current values of the attached performance counters
+ *                     can be called from any thread while the hsm is running
+ * Parameters        : none
+ * Return            : snapshot of the performance counters
+ * Note              : available with HSM_METRICS defined
+ ******************************************************************************/
+
+	Metrics::Snapshot snapshot() const
+	{
+		if (StateMachine::metrics == nullptr || StateMachine::def == nullptr)
+			return {};
+
+		return StateMachine::metrics->snapshot(StateMachine::def->states.data(), StateMachine::def->states.size(), StateMachine::def->values, StateMachine::def->width - 1);
+	}
+
+#endif
+/******************************************************************************
+ * Name              : hsm::StateMachine::post
+ * Description       : put user message to the queue of the hsm
+ *                     the message posted from the event handler is handled after the current message,
+ *                     otherwise the message is handled with the function 'dispatch'
+ * Parameters        :
+ *               msg : message
+ * Return            : false if the queue is full
+ ******************************************************************************/
+
+	bool post( const Message& message_ )
+	{
+		assert(StateMachine::getQueue() != nullptr);
+		assert(message_.event == Event::Stop || message_.event >= Event::User);
+
+		return StateMachine::getQueue()->push(message_);
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::dispatch
+ * Description       : handle all messages posted to the queue of the hsm
+ * Parameters        : none
+ * Return            : none
+ ******************************************************************************/
+
+	void dispatch()
+	{
+		Queue *queue_ = StateMachine::getQueue();
+
+		assert(queue_ != nullptr);
+
+		if (!queue_->busy)
+		{
+			if (StateMachine::getLive() != nullptr)
+				StateMachine::update();
+
+			queue_->busy = true;
+			StateMachine::drain();
+			queue_->busy = StateMachine::isSuspended();
+		}
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::follow
+ * Description       : run the current revision of the live definition
+ *                     with the queue attached, the hsm switches to the revision published later
+ *                     before handling the next message from outside the event handlers
+ * Parameters        :
+ *              live : live definition (LiveDefinition)
+ * Return            : none
+ * Note              : the hsm must be stopped and must not run the private definition
+ ******************************************************************************/
+
+	void follow( LiveDefinition& live_ )
+	{
+		assert(StateMachine::state == Definition::none);
+		assert(StateMachine::def == nullptr || StateMachine::getLive() != nullptr);
+
+		LiveDefinition::Revision *revision_ = live_.acquire();
+
+		if (StateMachine::getLive() != nullptr)
+			LiveDefinition::release(StateMachine::extension->revision);
+
+		StateMachine::def = &revision_->def;
+		StateMachine::extend()->live = &live_;
+		StateMachine::extension->revision = revision_;
+#ifdef HSM_METRICS
+		if (StateMachine::metrics != nullptr)
+			StateMachine::metrics->resize(StateMachine::def->states.size(), StateMachine::def->width);
+#endif
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::update
+ * Description       : switch to the current revision of the followed live definition
+ *                     current states and history are mapped to the states of the new revision,
+ *                     timeouts of the current states are armed again
+ * Parameters        : none
+ * Return            : true if the hsm has switched to the new revision
+ * Note              : called outside the event handlers; all current states must be kept by the new revision
+ ******************************************************************************/
+
+	bool update()
+	{
+		assert(StateMachine::getLive() != nullptr);
+		assert(StateMachine::getQueue() == nullptr || !StateMachine::getQueue()->busy);
+
+		Extension *extension_ = StateMachine::extension;
+
+		if (extension_->live->head.load(std::memory_order_acquire) == extension_->revision)
+			return false;
+
+		LiveDefinition::Revision *revision_ = extension_->live->acquire();
+		StateMachine::migrate(&revision_->def);
+		LiveDefinition::release(extension_->revision);
+		extension_->revision = revision_;
+
+		return true;
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::transition
+ * Description       : set the transition target state from the event handler
+ * Parameters        :
+ *            target : transition target state
+ * Return            : none
+ ******************************************************************************/
+
+	void transition( State& target_ )
+	{
+		StateMachine::target = StateMachine::getState(&target_);
+	}
+
+/******************************************************************************
+ *
+ * Class             : hsm::StateMachine::Suspension
+ *
+ * Description       : record of the user message which handling has been suspended
+ *                     provided by the suspending event handler (e.g. held by the coroutine frame of Task)
+ *                     and kept by the hsm until the function 'resume'
+ *
+ ******************************************************************************/
+
+	struct Suspension
+	{
+		unsigned owner{Definition::none};    // owner state of the suspended action, set when the event handler returns
+		Message message{};                   // suspended user message
+	};
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::suspend
+ * Description       : suspend the handling of the current user message from the event handler
+ *                     the hsm stays in the current state and queues all messages until the function 'resume'
+ *                     (e.g. the event handler waits for the asynchronous operation)
+ * Parameters        :
+ *        suspension : record of the suspended message, it must be kept until the function 'resume'
+ * Return            : none
+ * Note              : the queue must be attached; the hsm must not have orthogonal regions
+ *                     only the event handler of the action handling the user message can suspend,
+ *                     not the Exit, Entry and Init event handlers of the transition
+ ******************************************************************************/
+
+	void suspend( Suspension& suspension_ )
+	{
+		assert(StateMachine::getQueue() != nullptr && StateMachine::getQueue()->busy); // messages are queued while suspended
+		assert(StateMachine::def->regions == 0);
+		assert(!StateMachine::isSuspended());
+
+		suspension_ = {};
+		StateMachine::extension->suspension = &suspension_;
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::resume
+ * Description       : complete the handling of the suspended user message
+ *                     the transition set with the function 'transition' is done,
+ *                     then the queued messages are handled with run-to-completion semantics
+ * Parameters        : none
+ * Return            : none
+ * Note              : called from the event handler before it returns, the handling is not suspended
+ ******************************************************************************/
+
+	void resume()
+	{
+		assert(StateMachine::isSuspended());
+
+		const Suspension suspension_ = *StateMachine::extension->suspension;
+		StateMachine::extension->suspension = nullptr;
+
+		if (suspension_.owner == Definition::none) // the event handler has not returned yet
+			return;
+
+		if (StateMachine::target != suspension_.owner)
+			StateMachine::transition(StateMachine::target, StateMachine::def->getRoot(StateMachine::state, StateMachine::target), suspension_.message);
+
+		if (!StateMachine::isSuspended())
+		{
+			StateMachine::drain();
+			StateMachine::getQueue()->busy = StateMachine::isSuspended();
+		}
+	}
+
+/* -------------------------------------------------------------------------- */
+
+	private:
+	const Definition *def;               // hsm definition
+	unsigned state{Definition::none};    // index of the current hsm state
+	unsigned target{Definition::none};   // index of the transition target set by the user
+	                                     // in event handler procedure with the function 'transition'
+	struct Extension;
+	Extension *extension{};              // optional attachments, allocated on the first attachment
+#ifdef HSM_METRICS
+	Metrics *metrics{};                  // optional performance counters
+#endif
+#ifdef HSM_TRACE
+	unsigned chain{Definition::none};    // next action of the collapsed Init chain to be recorded
+#endif
+
+/******************************************************************************
+ *
+ * Class             : hsm::StateMachine::Extension
+ *
+ * Description       : optional attachments of the hsm instance
+ *                     allocated from the memory resource of the hsm definition on the first attachment,
+ *                     so the hsm without attachments holds only its definition and state indices
+ *
+ ******************************************************************************/
+
+	struct Extension
+	{
+		Extension( std::pmr::memory_resource *resource_ ): resource{resource_}, regions(resource_), history(resource_), timers(resource_) {}
+
+		std::pmr::memory_resource *resource; // memory resource providing the extension
+		Queue *queue{};                      // optional queue of posted messages
+		Queue *deferred{};                   // optional queue of deferred messages
+		Suspension *suspension{};            // record of the suspended user message
+		std::pmr::vector<unsigned> regions;  // current state of each orthogonal region (region 0: the whole hsm),
+		                                     // sized from the definition with orthogonal regions only
+		unsigned region{};                   // index of the orthogonal region being handled
+		std::pmr::vector<unsigned> history;  // state remembered by each state with history at its last exit,
+		                                     // sized from the definition with states with history only
+		TimerWheel *wheel{};                 // optional timer wheel of state timeouts
+		std::pmr::vector<unsigned> timers;   // armed timer of each state timeout, sized with the wheel attached only
+		LiveDefinition *live{};              // optional live definition followed by the hsm
+		LiveDefinition::Revision *revision{};// revision of the live definition run by the hsm
+	};
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::extend
+ * Description       : get the extension of the hsm, create it if necessary
+ * Parameters        : none
+ * Return            : pointer to the extension of the hsm
+ * Note              : for internal use
+ ******************************************************************************/
+
+	Extension* extend()
+	{
+		if (StateMachine::extension == nullptr)
+		{
+			std::pmr::memory_resource *resource_ = StateMachine::def != nullptr ? StateMachine::def->resource() : defaultResource();
+			StateMachine::extension = ::new (resource_->allocate(sizeof(Extension), alignof(Extension))) Extension{resource_};
+		}
+
+		return StateMachine::extension;
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::release
+ * Description       : destroy the extension of the hsm and release its memory to its memory resource
+ *                     the revision of the followed live definition is released
+ * Parameters        :
+ *         extension : pointer to the extension of the hsm
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	static void release( Extension *extension_ )
+	{
+		std::pmr::memory_resource *resource_ = extension_->resource;
+		if (extension_->revision != nullptr)
+			LiveDefinition::release(extension_->revision);
+		extension_->~Extension();
+		resource_->deallocate(extension_, sizeof(Extension), alignof(Extension));
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::getQueue
+ * Description       : get the attached queue of posted messages
+ * Parameters        : none
+ * Return            : pointer to the queue or nullptr
+ * Note              : for internal use
+ ******************************************************************************/
+
+	Queue* getQueue() const
+	{
+		return StateMachine::extension != nullptr ? StateMachine::extension->queue : nullptr;
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::getDeferred
+ * Description       : get the attached queue of deferred messages
+ * Parameters        : none
+ * Return            : pointer to the queue or nullptr
+ * Note              : for internal use
+ ******************************************************************************/
+
+	Queue* getDeferred() const
+	{
+		return StateMachine::extension != nullptr ? StateMachine::extension->deferred : nullptr;
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::getLive
+ * Description       : get the followed live definition
+ * Parameters        : none
+ * Return            : pointer to the live definition or nullptr
+ * Note              : for internal use
+ ******************************************************************************/
+
+	LiveDefinition* getLive() const
+	{
+		return StateMachine::extension != nullptr ? StateMachine::extension->live : nullptr;
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::getWheel
+ * Description       : get the attached timer wheel of state timeouts
+ * Parameters        : none
+ * Return            : pointer to the timer wheel or nullptr
+ * Note              : for internal use
+ ******************************************************************************/
+
+	TimerWheel* getWheel() const
+	{
+		return StateMachine::extension != nullptr ? StateMachine::extension->wheel : nullptr;
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::isScheduled
+ * Description       : check if the timers of state timeouts are armed on entry and disarmed on exit
+ * Parameters        : none
+ * Return            : true if the timer wheel is attached and the definition has state timeouts
+ * Note              : for internal use
+ ******************************************************************************/
+
+	bool isScheduled() const
+	{
+		return StateMachine::extension != nullptr && !StateMachine::extension->timers.empty();
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::isSuspended
+ * Description       : check if the handling of the user message has been suspended by the event handler
+ * Parameters        : none
+ * Return            : true if the handling is suspended
+ * Note              : for internal use
+ ******************************************************************************/
+
+	bool isSuspended() const
+	{
+		return StateMachine::extension != nullptr && StateMachine::extension->suspension != nullptr;
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::create
+ * Description       : create the private hsm definition in the given memory resource
+ * Parameters        :
+ *          resource : memory resource
+ * Return            : pointer to the private hsm definition
+ * Note              : for internal use
+ ******************************************************************************/
+
+	static Definition* create( std::pmr::memory_resource *resource_ )
+	{
+		return ::new (resource_->allocate(sizeof(Definition), alignof(Definition))) Definition{resource_};
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::destroy
+ * Description       : destroy the private hsm definition and release its memory to its memory resource
+ * Parameters        :
+ *               def : pointer to the private hsm definition
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	static void destroy( const Definition *def_ )
+	{
+		std::pmr::memory_resource *resource_ = def_->resource();
+		def_->~Definition();
+		resource_->deallocate(const_cast<Definition *>(def_), sizeof(Definition), alignof(Definition));
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::getDefinition
+ * Description       : get the private hsm definition, create it if necessary
+ * Parameters        : none
+ * Return            : pointer to the private hsm definition
+ * Note              : for internal use
+ ******************************************************************************/
+
+	Definition* getDefinition()
+	{
+		if (StateMachine::def == nullptr)
+			StateMachine::def = StateMachine::create(defaultResource());
+
+		if (StateMachine::def->owner == nullptr)
+			const_cast<Definition *>(StateMachine::def)->owner = this;
+
+		assert(StateMachine::def->owner == this);
+		assert(StateMachine::state == Definition::none);
+
+		return const_cast<Definition *>(StateMachine::def);
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::compile
+ * Description       : compile the private hsm definition
+ * Parameters        : none
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void compile()
+	{
+		assert(StateMachine::def->owner == this);
+
+		Definition *def_ = const_cast<Definition *>(StateMachine::def);
+		def_->compile();
+#ifdef HSM_METRICS
+		if (StateMachine::metrics != nullptr)
+			StateMachine::metrics->resize(def_->states.size(), def_->width);
+#endif
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::getState
+ * Description       : get index of the given hsm state
+ *                     the state missing in the private definition is added to it
+ * Parameters        :
+ *             state : pointer to hsm state
+ * Return            : hsm state index
+ * Note              : for internal use
+ ******************************************************************************/
+
+	unsigned getState( State *state_ )
+	{
+		if (StateMachine::def->owner == this && (!StateMachine::def->ready || StateMachine::def->find(state_) == Definition::none))
+		{
+			Definition *def_ = const_cast<Definition *>(StateMachine::def);
+			if (def_->find(state_) == Definition::none)
+				def_->add(*state_);
+			StateMachine::compile();
+		}
+
+		assert(StateMachine::def->ready);
+		assert(StateMachine::def->find(state_) != Definition::none);
+
+		return StateMachine::def->find(state_);
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::handle
+ * Description       : handle given user message
+ * Parameters        :
+ *               msg : message
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void handle( const Message& message_ )
+	{
+		if      (message_.event >= Event::User) StateMachine::eventHandler({message_, this});
+		else if (message_.event == Event::Stop) StateMachine::transition(Definition::none, {});
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::drain
+ * Description       : handle messages from the queue until the queue is empty,
+ *                     the hsm has been stopped or the event handler has been suspended
+ * Parameters        : none
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void drain()
+	{
+		Message message_;
+
+		while (StateMachine::state != Definition::none && !StateMachine::isSuspended() && StateMachine::getQueue()->pop(message_))
+			StateMachine::handle(message_);
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::callAction
+ * Description       : try to handle the message by the given hsm action
+ * Parameters        :
+ *            action : index of action handling the event
+ *           message : received message
+ * Return            : assigned action exist; message has been handled
+ * Note              : for internal use
+ ******************************************************************************/
+
+	bool callAction( unsigned action_, const Message& message_ )
+	{
+		if (action_ == Definition::none)
+		{
+			if (message_.event >= Event::User)
+				HSM_TRACE_RECORD(Unhandled, StateMachine::state, message_.event, Definition::none);
+			return false;
+		}
+
+		const Definition::Link link_ = StateMachine::def->getLink(action_);
+
+		if (StateMachine::def->isDeferred(action_))
+		{
+			Queue *deferred_ = StateMachine::getDeferred();
+
+			assert(deferred_ != nullptr); // the deferral queue must be attached with the function 'defer'
+
+			if (deferred_ == nullptr || !deferred_->push(message_))
+			{
+				HSM_TRACE_RECORD(Unhandled, StateMachine::state, message_.event, action_);
+				return false; // the message cannot be deferred; it's passed to the outer states
+			}
+
+			HSM_TRACE_RECORD(Action, link_.owner, message_.event, action_);
+			return true;
+		}
+
+		if (message_.event == Event::Init)
+			HSM_TRACE_RECORD(Init, link_.owner, message_.event, action_);
+		else
+			HSM_TRACE_RECORD(Action, link_.owner, message_.event, action_);
+
+		StateMachine::target = link_.owner;
+
+		unsigned target_ = StateMachine::def->callHandler(action_, message_) ? StateMachine::target : link_.target;
+#ifdef HSM_TRACE
+		StateMachine::chain = message_.event == Event::Init ? StateMachine::def->getChain(action_) : Definition::none;
+#endif
+
+		if (StateMachine::isSuspended())
+		{
+			assert(message_.event >= Event::User); // the Init event handler must not suspend
+
+			StateMachine::extension->suspension->owner = link_.owner;
+			StateMachine::extension->suspension->message = message_;
+			return true;
+		}
+
+		if (target_ == link_.owner)
+			return true;
+
+		assert(message_.event >= Event::User || StateMachine::def->getPrev(target_) == link_.owner ||
+		      (target_ == link_.target && StateMachine::def->getRoot(link_.owner, target_) == link_.owner)); // extended Init transition
+
+		// the cached root is valid unless the direct transition target is the descendant
+		// of the owner state and the message is handled by the ancestor of the current state
+		if (target_ == link_.target && (link_.root != link_.owner || StateMachine::state == link_.owner))
+			StateMachine::transition(target_, link_.root, message_);
+		else
+			StateMachine::transition(target_, StateMachine::def->getRoot(StateMachine::state, target_), message_);
+
+		return true;
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::callHandler
+ * Description       : invoke event handler assigned to the given state and system event
+ * Parameters        :
+ *             state : index of state receiving the message
+ *           message : received message
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void callHandler( unsigned state_, const Message& message_ )
+	{
+		if (StateMachine::isScheduled())
+			StateMachine::schedule(state_, message_.event == Event::Entry);
+
+		unsigned action_ = StateMachine::def->getAction(state_, message_.event - Event::Exit);
+
+#ifdef HSM_METRICS
+		if (StateMachine::metrics != nullptr)
+		{
+			std::uint64_t time_ = HSM_METRICS_CLOCK();
+			std::uint64_t latency_ = 0;
+
+			if (action_ != Definition::none)
+			{
+				StateMachine::callHandler(state_, action_, message_);
+				latency_ = HSM_METRICS_CLOCK() - time_;
+			}
+
+			if (message_.event == Event::Exit)
+				StateMachine::metrics->exit(state_, time_ + latency_, latency_);
+			else
+				StateMachine::metrics->entry(state_, time_, latency_);
+
+			return;
+		}
+#endif
+		if (action_ != Definition::none)
+			StateMachine::callHandler(state_, action_, message_);
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::callHandler
+ * Description       : invoke the given event handler of the given state and system event
+ * Parameters        :
+ *             state : index of state receiving the message
+ *            action : index of the action assigned to the state and system event
+ *           message : received message
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void callHandler( [[maybe_unused]] unsigned state_, unsigned action_, const Message& message_ )
+	{
+		if (message_.event == Event::Exit)
+			HSM_TRACE_RECORD(Exit, state_, message_.event, action_);
+		else
+			HSM_TRACE_RECORD(Entry, state_, message_.event, action_);
+
+		StateMachine::def->callHandler(action_, message_);
+
+		assert(!StateMachine::isSuspended()); // the Exit and Entry event handlers must not suspend
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::transition
+ * Description       : do the transition to the given target state
+ * Parameters        :
+ *              next : index of transition target state
+ *           message : handled message
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void transition( unsigned next_, const Message& message_ )
+	{
+		StateMachine::transition(next_, StateMachine::def->getRoot(StateMachine::state, next_), message_);
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::transition
+ * Description       : do the transition to the given target state through the given root state
+ * Parameters        :
+ *              next : index of transition target state
+ *              root : index of common ancestor of the current and the target state
+ *           message : handled message
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void transition( unsigned next_, unsigned root_, const Message& message_ )
+	{
+		HSM_TRACE_RECORD(Transition, StateMachine::state, message_.event, StateMachine::chain != Definition::none ? StateMachine::def->getLink(StateMachine::chain).owner : next_);
+
+		if (StateMachine::def->regions != 0)
+			return StateMachine::transfer(next_, root_, message_);
+
+		if (StateMachine::def->memories != 0)
+			StateMachine::remember(root_);
+
+		const Message exit_{message_, Event::Exit};
+		while (StateMachine::state != root_)
+		{
+			StateMachine::callHandler(StateMachine::state, exit_);
+			StateMachine::state = StateMachine::def->getPrev(StateMachine::state);
+		}
+
+		const Message entry_{message_, Event::Entry};
+		while (StateMachine::state != next_)
+		{
+			StateMachine::state = StateMachine::def->getNext(StateMachine::state, next_);
+			StateMachine::callHandler(StateMachine::state, entry_);
+#ifdef HSM_TRACE
+			StateMachine::record(message_);
+#endif
+		}
+
+		StateMachine::init(message_);
+
+		if (StateMachine::getDeferred() != nullptr)
+			StateMachine::replay();
+	}
+
+#ifdef HSM_TRACE
+/******************************************************************************
+ * Name              : hsm::StateMachine::record
+ * Description       : record the Init transition of the collapsed chain done by the entry to the current state
+ *                     the collapsed transition enters the states of the chain in one pass,
+ *                     the trace records the same sequence as the chain of single transitions
+ * Parameters        :
+ *           message : handled message
+ * Return            : none
+ * Note              : for internal use; available with HSM_TRACE defined
+ ******************************************************************************/
+
+	void record( const Message& message_ )
+	{
+		const unsigned action_ = StateMachine::chain;
+
+		if (action_ == Definition::none || StateMachine::def->getLink(action_).owner != StateMachine::state)
+			return;
+
+		StateMachine::chain = StateMachine::def->getChain(action_);
+
+		HSM_TRACE_RECORD(Init, StateMachine::state, Event::Init, action_);
+		HSM_TRACE_RECORD(Transition, StateMachine::state, message_.event, StateMachine::chain != Definition::none ? StateMachine::def->getLink(StateMachine::chain).owner : StateMachine::def->getLink(action_).target);
+	}
+
+#endif
+#if defined(HSM_TRACE) || defined(HSM_METRICS)
+/******************************************************************************
+ * Name              : hsm::StateMachine::jump
+ * Description       : do the pure transition resolved by the jump table of StateMachineArray
+ *                     no event handlers are called; the trace and the performance counters
+ *                     record the same sequence as the message handled by the hsm
+ * Parameters        :
+ *           message : handled user message
+ * Return            : none
+ * Note              : for internal use; available with HSM_TRACE or HSM_METRICS defined
+ ******************************************************************************/
+
+	void jump( const Message& message_ )
+	{
+		const unsigned column_ = StateMachine::def->getColumn(message_.event);
+		unsigned action_ = StateMachine::def->getAction(StateMachine::state, column_);
+
+#ifdef HSM_METRICS
+		if (StateMachine::metrics != nullptr)
+			StateMachine::metrics->event(StateMachine::state, column_, action_ == Definition::none ? Definition::none :
+				StateMachine::def->getLevel(StateMachine::state) - StateMachine::def->getLevel(StateMachine::def->getLink(action_).owner));
+#endif
+		if (action_ == Definition::none)
+		{
+			HSM_TRACE_RECORD(Unhandled, StateMachine::state, message_.event, Definition::none);
+			return;
+		}
+
+		HSM_TRACE_RECORD(Action, StateMachine::def->getLink(action_).owner, message_.event, action_);
+
+		const Message init_{message_, Event::Init};
+		for (const Message *event_ = &message_;; event_ = &init_)
+		{
+			const Definition::Link link_ = StateMachine::def->getLink(action_);
+
+			if (link_.target == link_.owner)
+				return;
+
+			const unsigned root_ = StateMachine::def->getRoot(StateMachine::state, link_.target);
+#ifdef HSM_TRACE
+			StateMachine::chain = event_ == &init_ ? StateMachine::def->getChain(action_) : Definition::none;
+#endif
+			HSM_TRACE_RECORD(Transition, StateMachine::state, event_->event, StateMachine::chain != Definition::none ? StateMachine::def->getLink(StateMachine::chain).owner : link_.target);
+#ifdef HSM_METRICS
+			std::uint64_t time_ = StateMachine::metrics != nullptr ? HSM_METRICS_CLOCK() : 0;
+#endif
+			while (StateMachine::state != root_)
+			{
+#ifdef HSM_METRICS
+				if (StateMachine::metrics != nullptr)
+					StateMachine::metrics->exit(StateMachine::state, time_, 0);
+#endif
+				StateMachine::state = StateMachine::def->getPrev(StateMachine::state);
+			}
+
+			while (StateMachine::state != link_.target)
+			{
+				StateMachine::state = StateMachine::def->getNext(StateMachine::state, link_.target);
+#ifdef HSM_METRICS
+				if (StateMachine::metrics != nullptr)
+					StateMachine::metrics->entry(StateMachine::state, time_, 0);
+#endif
+#ifdef HSM_TRACE
+				StateMachine::record(*event_);
+#endif
+			}
+
+			action_ = StateMachine::def->getAction(StateMachine::state, Event::Init - Event::Exit);
+			if (action_ == Definition::none)
+				return;
+
+			HSM_TRACE_RECORD(Init, StateMachine::state, Event::Init, action_);
+		}
+	}
+
+#endif
+/******************************************************************************
+ * Name              : hsm::StateMachine::schedule
+ * Description       : arm or disarm the timers of state timeouts owned by the given state
+ * Parameters        :
+ *             state : index of the entered or exited state
+ *               arm : true on entry to the state, false on exit
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void schedule( unsigned state_, bool arm_ )
+	{
+		for (unsigned timer_ = StateMachine::def->getTimer(state_); StateMachine::def->ownsTimer(timer_, state_); timer_++)
+		{
+			unsigned& armed_ = StateMachine::extension->timers[timer_];
+
+			if (armed_ != Definition::none)
+				StateMachine::extension->wheel->disarm(armed_);
+
+			armed_ = arm_ ? StateMachine::extension->wheel->arm(StateMachine::def->getDelay(timer_), &StateMachine::expire, this, timer_) : Definition::none;
+			assert(!arm_ || armed_ != Definition::none); // the capacity of the timer wheel must be sufficient
+		}
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::cancel
+ * Description       : disarm all armed timers of state timeouts
+ * Parameters        : none
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void cancel()
+	{
+		if (StateMachine::extension == nullptr)
+			return;
+
+		for (unsigned& armed_: StateMachine::extension->timers)
+		{
+			if (armed_ != Definition::none)
+				StateMachine::extension->wheel->disarm(armed_);
+			armed_ = Definition::none;
+		}
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::migrate
+ * Description       : switch to the given definition, mapping the current configuration by the state objects
+ * Parameters        :
+ *               def : new hsm definition
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void migrate( const Definition *def_ )
+	{
+		const Definition *prev_ = StateMachine::def;
+		auto map_ = [prev_, def_]( unsigned state_ ){ return state_ != Definition::none ? def_->find(prev_->states[state_]) : Definition::none; };
+
+		StateMachine::cancel();
+		StateMachine::def = def_;
+		StateMachine::target = Definition::none;
+#ifdef HSM_METRICS
+		if (StateMachine::metrics != nullptr)
+			StateMachine::metrics->resize(def_->states.size(), def_->width);
+#endif
+		if (StateMachine::state == Definition::none)
+			return;
+
+		assert(map_(StateMachine::state) != Definition::none); // the current state must be kept by the new revision
+		assert(def_->regions == prev_->regions);
+
+		if (def_->regions != 0)
+		{
+			std::pmr::vector<unsigned>& current_ = StateMachine::extension->regions;
+			std::pmr::vector<unsigned> regions_(def_->regions + 1, Definition::none, current_.get_allocator());
+			for (std::size_t region_ = 1; region_ < current_.size(); region_++)
+			{
+				unsigned active_ = map_(current_[region_]);
+				assert(active_ != Definition::none || current_[region_] == Definition::none);
+				if (active_ != Definition::none)
+					regions_[def_->getRegion(active_)] = active_;
+			}
+			current_ = std::move(regions_);
+		}
+
+		if (def_->memories != 0)
+		{
+			std::pmr::vector<unsigned>& current_ = StateMachine::extend()->history;
+			std::pmr::vector<unsigned> history_(def_->memories, Definition::none, current_.get_allocator());
+			for (unsigned state_ = 0; prev_->memories != 0 && state_ < prev_->states.size(); state_++)
+			{
+				unsigned memory_ = prev_->getMemory(state_);
+				unsigned other_ = memory_ != Definition::none && memory_ < current_.size() ? map_(state_) : Definition::none;
+				if (other_ != Definition::none && def_->getMemory(other_) != Definition::none)
+					history_[def_->getMemory(other_)] = map_(current_[memory_]);
+			}
+			current_ = std::move(history_);
+		}
+		else
+		if (StateMachine::extension != nullptr)
+		{
+			StateMachine::extension->history.clear();
+		}
+
+		StateMachine::state = map_(StateMachine::state);
+
+		if (StateMachine::extension != nullptr)
+			StateMachine::extension->timers.clear();
+		if (StateMachine::getWheel() != nullptr && def_->timeouts != 0)
+		{
+			StateMachine::extension->timers.assign(def_->timeouts, Definition::none);
+			for (std::size_t region_ = 0; region_ <= def_->regions; region_++)
+			{
+				unsigned active_ = region_ == 0 ? StateMachine::state : StateMachine::extension->regions[region_];
+				unsigned bound_ = region_ == 0 ? Definition::none : def_->getPrev(def_->getOrigin(static_cast<unsigned>(region_)));
+				for (; active_ != Definition::none && active_ != bound_; active_ = def_->getPrev(active_))
+					StateMachine::schedule(active_, true);
+			}
+		}
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::expire
+ * Description       : send the user event of the expired state timeout to the hsm
+ * Parameters        :
+ *           context : pointer to the hsm
+ *             timer : index of the state timeout
+ * Return            : none
+ * Note              : for internal use
+ *                     if the event is dropped by the full queue, the timeout is retried at the next tick
+ ******************************************************************************/
+
+	static void expire( void *context_, unsigned timer_ )
+	{
+		StateMachine *hsm_ = static_cast<StateMachine *>(context_);
+
+		Extension *extension_ = hsm_->extension;
+
+		extension_->timers[timer_] = Definition::none;
+		if (!hsm_->message({hsm_->def->getEvent(timer_)}))
+			extension_->timers[timer_] = extension_->wheel->arm(1, &StateMachine::expire, hsm_, timer_);
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::replay
+ * Description       : handle the deferred messages in the current state after transition
+ *                     the messages are popped in one pass up to the tail of the queue at the start of the pass;
+ *                     the message deferred again is pushed back behind the tail, others are handled;
+ *                     the transition during the pass does not start the nested replay,
+ *                     it requests the next pass instead, as it may end the deferral of the messages pushed back;
+ *                     the pass without any transition is the last one
+ * Parameters        : none
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void replay()
+	{
+		Queue *deferred_ = StateMachine::getDeferred();
+
+		if (deferred_->busy)
+			deferred_->again = true;
+
+		if (deferred_->busy || deferred_->size() == 0)
+			return;
+
+		deferred_->busy = true;
+
+		do
+		{
+			deferred_->again = false;
+			for (std::size_t count_ = deferred_->size(); count_ > 0 && StateMachine::state != Definition::none && !StateMachine::isSuspended(); count_--)
+			{
+				Message message_;
+				deferred_->pop(message_);
+				StateMachine::eventHandler(message_);
+			}
+		}
+		while (deferred_->again);
+
+		deferred_->busy = false;
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::init
+ * Description       : init the current state after transition
+ *                     the state with remembered history is entered to the remembered state,
+ *                     regions of the parallel state are entered,
+ *                     other states handle Event::Init
+ * Parameters        :
+ *           message : handled message
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void init( const Message& message_ )
+	{
+		if (StateMachine::def->memories != 0)
+		{
+			unsigned memory_ = StateMachine::def->getMemory(StateMachine::state);
+			unsigned next_ = memory_ != Definition::none ? StateMachine::extension->history[memory_] : Definition::none;
+
+			if (next_ != Definition::none)
+			{
+				const bool deep_ = StateMachine::def->isDeep(StateMachine::state);
+
+				while (StateMachine::state != next_)
+				{
+					StateMachine::state = StateMachine::def->getNext(StateMachine::state, next_);
+					StateMachine::callHandler(StateMachine::state, {message_, Event::Entry});
+				}
+
+				if (!deep_)
+					return StateMachine::init(message_);
+
+				if (StateMachine::def->regions != 0 && StateMachine::def->getBranch(StateMachine::state) != Definition::none)
+					StateMachine::enterRegions(Definition::none, message_);
+
+				return;
+			}
+		}
+
+		if (StateMachine::def->regions != 0 && StateMachine::def->getBranch(StateMachine::state) != Definition::none)
+			StateMachine::enterRegions(Definition::none, message_);
+		else
+		{
+			const Message init_{message_, Event::Init};
+			StateMachine::callAction(StateMachine::def->resolve(StateMachine::def->getAction(StateMachine::state, Event::Init - Event::Exit), init_), init_);
+		}
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::remember
+ * Description       : update the history of states to be exited up to the given root state
+ *                     the state with shallow history remembers its active child state,
+ *                     the state with deep history remembers the current state
+ * Parameters        :
+ *              root : index of the root state
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void remember( unsigned root_ )
+	{
+		unsigned prev_ = Definition::none;
+
+		for (unsigned state_ = StateMachine::state; state_ != root_; prev_ = state_, state_ = StateMachine::def->getPrev(state_))
+		{
+			unsigned memory_ = StateMachine::def->getMemory(state_);
+			if (memory_ != Definition::none)
+				StateMachine::extension->history[memory_] = StateMachine::def->isDeep(state_) ? (state_ != StateMachine::state ? StateMachine::state : Definition::none) : prev_;
+		}
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::eventHandler
+ * Description       : internal event handler procedure
+ * Parameters        :
+ *           message : received message
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void eventHandler( const Message& message_ )
+	{
+		unsigned column_ = StateMachine::def->getColumn(message_.event);
+
+		if (StateMachine::def->regions != 0)
+		{
+			assert(StateMachine::extension->region == 0); // messages sent from event handlers of regions must be queued
+
+			if (!StateMachine::dispatch(column_, message_))
+			{
+#ifdef HSM_METRICS
+				if (StateMachine::metrics != nullptr)
+					StateMachine::metrics->event(StateMachine::state, column_, Definition::none);
+#endif
+				StateMachine::callAction(Definition::none, message_);
+			}
+
+			assert(StateMachine::extension->region == 0);
+			return;
+		}
+
+		unsigned action_ = StateMachine::def->resolve(StateMachine::def->getAction(StateMachine::state, column_), message_);
+
+#ifdef HSM_METRICS
+		if (StateMachine::metrics != nullptr)
+			StateMachine::metrics->event(StateMachine::state, column_, action_ == Definition::none ? Definition::none :
+				StateMachine::def->getLevel(StateMachine::state) - StateMachine::def->getLevel(StateMachine::def->getLink(action_).owner));
+#endif
+		StateMachine::callAction(action_, message_);
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachine::dispatch
+ * Description       : handle the message by the current state of the current orthogonal region
+ *                     regions of the parallel state are handled first, in the order of regions;
+ *                     the parallel state and its ancestors handle the message not handled by any region
+ * Parameters        :
+ *            column : dispatch table column assigned to the event
+ *           message : received message
+ * Return            : true if the message has been handled
+ * Note              : for internal use
+ ******************************************************************************/
+
+	bool dispatch( unsigned column_, const Message& message_ )
+	{
+		const unsigned region_ = StateMachine::extension->region;
+		const unsigned state_ = StateMachine::state;
+		const unsigned first_ = StateMachine::def->getBranch(state_);
+
+		if (first_ != Definition::none)
+		{
+			bool handled_ = false;
+
+			for (unsigned next_ = first_; next_ < StateMachine::def->getBound(state_); next_++)
+			{
+				StateMachine::select(next_);
+				handled_ = StateMachine::dispatch(column_, message_) || handled_;
+
+				if (StateMachine::extension->region != next_) // the transition has left the region
+					return true;
+
+				StateMachine::select(region_);
+			}
+
+			if (handled_)
+				return true;
+		}
+
+		unsigned action_ = StateMachine::def->resolve(StateMachine::def->getAction(state_, column_), message_);
+		if (action_ == Definition::none)
+			return false;
+
+		unsigned owner_ = StateMachine::def->getLink(action_).owner;
+		if (!StateMachine::def->contains(region_, owner_)) // the message is handled outside the region
+			return false;
+
+#ifdef HSM_METRICS
+		if (StateMachine::metrics != nullptr)
+			StateMachine::metrics->event(state_, column_, StateMachine::def->getLevel(state_) - StateMachine::def->getLevel(owner_));
+#endif
+		return StateMachine::callAction(action_, message_);
+	}
 
 /******************************************************************************
- *
- * Class             : State
- *
- * Description       : hsm state object
- *
- * Constructor parameters
- *            parent : state parent in the hsm tree
- *
+ * Name              : hsm::StateMachine::select
+ * Description       : switch to the given orthogonal region
+ *                     the current state of the current region is stored, the state of the given region is loaded
+ * Parameters        :
+ *            region : region index (0 for the whole hsm)
+ * Return            : index of the previous region
+ * Note              : for internal use
  ******************************************************************************/
 
-struct State
-{
-	constexpr State() {}
-	constexpr State( State& parent_ ): parent{&parent_} {}
-
-	State( State&& ) = default;
-	State( const State& ) = delete;
-	State& operator=( State&& ) = delete;
-	State& operator=( const State& ) = delete;
+	unsigned select( unsigned region_ )
+	{
+		unsigned prev_ = StateMachine::extension->region;
 
-/* -------------------------------------------------------------------------- */
+		StateMachine::extension->regions[prev_] = StateMachine::state;
+		StateMachine::extension->region = region_;
+		StateMachine::state = StateMachine::extension->regions[region_];
 
-	private:
-	State *parent{}; // pointer to parent state in the hsm tree
-	Action *queue{}; // state action queue
+		return prev_;
+	}
 
 /******************************************************************************
- * Name              : hsm::State::getLevel
- * Description       : calculate state level in the hsm state tree
+ * Name              : hsm::StateMachine::transfer
+ * Description       : do the transition to the given target state through the given root state
+ *                     in the hsm with orthogonal regions
+ *                     regions not containing the root state are left,
+ *                     regions of the parallel root state are entered again
  * Parameters        :
- *             state : pointer to hsm state
- * Return            : state level for given hsm state
+ *              next : index of transition target state
+ *              root : index of common ancestor of the current and the target state
+ *           message : handled message
+ * Return            : none
  * Note              : for internal use
  ******************************************************************************/
 
-	static int getLevel( State *state_ )
+	void transfer( unsigned next_, unsigned root_, const Message& message_ )
 	{
-		int level_ = 0;
+		while (StateMachine::extension->region != 0 && !StateMachine::def->contains(StateMachine::extension->region, root_))
+			StateMachine::leave(message_);
 
-		while (state_ != nullptr)
+		StateMachine::exit(root_, message_);
+
+		if (StateMachine::def->getBranch(StateMachine::state) != Definition::none)
 		{
-			level_++;
-			state_ = state_->parent;
+			StateMachine::exitRegions(message_);
+			StateMachine::enterRegions(next_, message_);
+		}
+		else
+		{
+			StateMachine::enter(next_, message_);
 		}
-
-		return level_;
 	}
 
 /******************************************************************************
- * Name              : hsm::State::getRoot
- * Description       : get pointer to root state for hsm state and the other
+ * Name              : hsm::StateMachine::leave
+ * Description       : exit all states of the current orthogonal region
+ *                     and switch to the region of its parallel state
  * Parameters        :
- *             state : pointer to hsm state
- *             other : pointer to the other hsm state
- * Return            : pointer to root state
+ *           message : handled message
+ * Return            : none
  * Note              : for internal use
  ******************************************************************************/
 
-	static State* getRoot( State *state_, State *other_ )
+	void leave( const Message& message_ )
 	{
-		int diff_ = State::getLevel(state_) - State::getLevel(other_);
+		unsigned region_ = StateMachine::extension->region;
+		unsigned parent_ = StateMachine::def->getPrev(StateMachine::def->getOrigin(region_));
 
-		while (diff_-- > 0) state_ = state_->parent;
-		while (++diff_ < 0) other_ = other_->parent;
-		while (state_ != other_)
-		{
-			state_ = state_->parent;
-			other_ = other_->parent;
-		}
+		StateMachine::exit(parent_, message_);
+
+		StateMachine::extension->regions[region_] = Definition::none;
+		StateMachine::extension->region = StateMachine::def->getRegion(parent_);
+		StateMachine::state = StateMachine::extension->regions[StateMachine::extension->region];
 
-		return state_;
+		assert(StateMachine::state == parent_);
 	}
 
 /******************************************************************************
- * Name              : hsm::State::getQueue
- * Description       : get pointer to the first action in the state action queue
- * Parameters        : none
- * Return            : pointer to the first action in the state action queue
+ * Name              : hsm::StateMachine::exit
+ * Description       : exit states of the current orthogonal region up to the given root state
+ *                     regions of the parallel states are exited before the parallel state
+ * Parameters        :
+ *              root : index of the root state
+ *           message : handled message
+ * Return            : none
  * Note              : for internal use
  ******************************************************************************/
 
-	Action* getQueue()
+	void exit( unsigned root_, const Message& message_ )
 	{
-		return State::queue;
+		if (StateMachine::def->memories != 0)
+			StateMachine::remember(root_);
+
+		while (StateMachine::state != root_)
+		{
+			if (StateMachine::def->getBranch(StateMachine::state) != Definition::none)
+				StateMachine::exitRegions(message_);
+
+			StateMachine::callHandler(StateMachine::state, {message_, Event::Exit});
+			StateMachine::state = StateMachine::def->getPrev(StateMachine::state);
+		}
 	}
 
 /******************************************************************************
- * Name              : hsm::State::setQueue
- * Description       : set the state action queue
+ * Name              : hsm::StateMachine::exitRegions
+ * Description       : exit all active regions of the current parallel state in reverse order
  * Parameters        :
- *            action : pointer to the first action in the state action queue
+ *           message : handled message
  * Return            : none
  * Note              : for internal use
  ******************************************************************************/
 
-	void setQueue( Action* action_ )
+	void exitRegions( const Message& message_ )
 	{
-		State::queue = action_;
+		const unsigned state_ = StateMachine::state;
+		const unsigned first_ = StateMachine::def->getBranch(state_);
+
+		for (unsigned region_ = StateMachine::def->getBound(state_); region_-- > first_;)
+		{
+			if (StateMachine::extension->regions[region_] == Definition::none)
+				continue;
+
+			unsigned prev_ = StateMachine::select(region_);
+			StateMachine::exit(state_, message_);
+			StateMachine::select(prev_);
+			StateMachine::extension->regions[region_] = Definition::none;
+		}
 	}
 
 /******************************************************************************
- * Name              : hsm::State::getPrev
- * Description       : get the parent of the hsm state
+ * Name              : hsm::StateMachine::enter
+ * Description       : enter states of the current orthogonal region down to the given target state
+ *                     and init the target state; regions of the parallel states are entered
+ *                     after the parallel state, instead of its init
  * Parameters        :
- *             state : pointer to given hsm state
- * Return            : pointer to the parent state
+ *              next : index of transition target state
+ *           message : handled message
+ * Return            : none
  * Note              : for internal use
  ******************************************************************************/
 
-	static State* getPrev( State *state_ )
+	void enter( unsigned next_, const Message& message_ )
 	{
-		if (state_ != nullptr)
-			state_ = state_->parent;
+		while (StateMachine::state != next_)
+		{
+			StateMachine::state = StateMachine::def->getNext(StateMachine::state, next_);
+			StateMachine::callHandler(StateMachine::state, {message_, Event::Entry});
+#ifdef HSM_TRACE
+			StateMachine::record(message_);
+#endif
 
-		return state_;
+			if (StateMachine::state != next_ && StateMachine::def->getBranch(StateMachine::state) != Definition::none)
+				return StateMachine::enterRegions(next_, message_);
+		}
+
+		StateMachine::init(message_);
 	}
 
 /******************************************************************************
- * Name              : hsm::State::getNext
- * Description       : get child state in the child branch 
+ * Name              : hsm::StateMachine::enterRegions
+ * Description       : enter all regions of the current parallel state in order
+ *                     the region containing the transition target state is entered down to the target,
+ *                     other regions are entered to its root state
  * Parameters        :
- *             state : pointer to given hsm state
- *              sign : pointer to the hsm state in the child branch
- * Return            : pointer to the child state
+ *              next : index of transition target state or 'Definition::none'
+ *           message : handled message
+ * Return            : none
  * Note              : for internal use
  ******************************************************************************/
 
-	static State* getNext( State *state_, State *sign_ )
+	void enterRegions( unsigned next_, const Message& message_ )
 	{
-		while (sign_ != nullptr)
+		const unsigned state_ = StateMachine::state;
+		const unsigned first_ = StateMachine::def->getBranch(state_);
+
+		for (unsigned region_ = first_; region_ < StateMachine::def->getBound(state_); region_++)
 		{
-			if (state_ == sign_->parent)
-				break;
-			sign_ = sign_->parent;
+			unsigned prev_ = StateMachine::select(region_);
+			StateMachine::state = state_;
+			StateMachine::enter(next_ != Definition::none && StateMachine::def->contains(region_, next_) ? next_ : StateMachine::def->getOrigin(region_), message_);
+			StateMachine::select(prev_);
 		}
-
-		return sign_;
 	}
 
-	friend struct Action;
-	friend struct StateMachine;
+	friend struct StateMachineArray;
+	friend struct Inbox;
 };
 
 /******************************************************************************
  *
- * Class             : Action
+ * Class             : StateMachineArray
  *
- * Description       : hsm action object
+ * Description       : array of hsm instances running the shared hsm definition
+ *                     current states of all instances are stored in one array,
+ *                     messages are handled in batches by one hsm object,
+ *                     the 'hsm' field of the message passed to event handler
+ *                     points to the hsm object of the array
+ *                     the definition must not have orthogonal regions, states with history,
+ *                     state timeouts and deferred events
  *
  * Constructor parameters
- *                   : none
+ *               def : shared hsm definition
+ *             count : number of hsm instances
+ *          resource : memory resource providing the storage of states
+ *                     (default: hsm::defaultResource())
  *
  ******************************************************************************/
 
-struct Action
+struct StateMachineArray
 {
-	Action( State& owner_, unsigned event_ ):                   owner{owner_}, event{event_}, action{& owner_} {}
-	Action( State& owner_, unsigned event_, State&  state_ ):   owner{owner_}, event{event_}, action{& state_} {}
-	Action( State& owner_, unsigned event_, Handler handler_ ): owner{owner_}, event{event_}, action{handler_} {}
-
-	Action( Action&& ) = default;
-	Action( const Action& ) = default;
-	Action& operator=( Action&& ) = delete;
-	Action& operator=( const Action& ) = delete;
+	StateMachineArray( const Definition& def_, std::size_t count_, std::pmr::memory_resource *resource_ = defaultResource() ):
+		hsm{def_}, states(count_, Definition::none, resource_), jumps(resource_) { assert(def_.regions == 0 && def_.memories == 0 && def_.timeouts == 0 && !StateMachineArray::defers(def_)); StateMachineArray::compile(); }
 
-/* -------------------------------------------------------------------------- */
+	StateMachineArray( StateMachineArray&& ) = delete;
+	StateMachineArray( const StateMachineArray& ) = delete;
+	StateMachineArray& operator=( StateMachineArray&& ) = delete;
+	StateMachineArray& operator=( const StateMachineArray& ) = delete;
 
-	private:
-	State&   owner; // action owner state
-	unsigned event; // action event value
-	Variant action; // transition target state or event handler
-	Action *next{}; // next element in the hsm state action queue
+/******************************************************************************
+ * Name              : hsm::StateMachineArray::size
+ * Description       : get number of hsm instances
+ * Parameters        : none
+ * Return            : number of hsm instances
+ ******************************************************************************/
 
-	struct Visitor
+	std::size_t size() const
 	{
-		Visitor(const Message& message_): message{message_} {}
+		return StateMachineArray::states.size();
+	}
 
-		State* operator()(State*  state_)   const { return state_; }
-		State* operator()(Handler handler_) const { handler_(Action::Visitor::message); return nullptr; }
+/******************************************************************************
+ * Name              : hsm::StateMachineArray::current
+ * Description       : get index of hsm instance handling the message; use it in event handler
+ * Parameters        : none
+ * Return            : index of hsm instance
+ ******************************************************************************/
 
-		private:
-		const Message& message;
-	};
+	std::size_t current() const
+	{
+		return StateMachineArray::index;
+	}
 
 /******************************************************************************
- * Name              : hsm::Action::getAction
- * Description       : get action assigned to the given state and event value
+ * Name              : hsm::StateMachineArray::start
+ * Description       : start all hsm instances
  * Parameters        :
- *             state : state receiving the message
- *             event : event value in the message
- * Return            : pointer to the assigned action
- * Note              : for internal use
+ *              init : initial hsm state
+ * Return            : none
  ******************************************************************************/
 
-	static Action* getAction( State *state_, unsigned event_ )
+	void start( State& init_ )
 	{
-		if (state_ == nullptr)
-			return nullptr;
-
-		Action *action_ = state_->getQueue();
+		for (std::size_t index_ = 0; index_ < StateMachineArray::states.size(); index_++)
+			StateMachineArray::start(index_, init_);
+	}
 
-		while (action_ != nullptr && action_->event != event_ && action_->event != Event::ALL)
-			action_ = action_->next;
+/******************************************************************************
+ * Name              : hsm::StateMachineArray::start
+ * Description       : start given hsm instance
+ * Parameters        :
+ *             index : index of hsm instance
+ *              init : initial hsm state
+ * Return            : none
+ ******************************************************************************/
 
-		return action_;
+	void start( std::size_t index_, State& init_ )
+	{
+		StateMachineArray::select(index_);
+		StateMachineArray::hsm.start(init_);
+		StateMachineArray::states[index_] = StateMachineArray::hsm.state;
 	}
 
 /******************************************************************************
- * Name              : hsm::Action::callHandler
- * Description       : invoke event handler assigned to the given action, if such a variant exists
+ * Name              : hsm::StateMachineArray::message
+ * Description       : handle given user message by given hsm instance
  * Parameters        :
- *             state : state receiving the message
- *           message : received message
- * Return            : pointer to the assigned action
- * Note              : for internal use
+ *             index : index of hsm instance
+ *               msg : message
+ * Return            : none
  ******************************************************************************/
 
-	static State* callHandler( State *state_, const Message& message_ )
+	void message( std::size_t index_, const Message& message_ )
 	{
-		Action *action_ = Action::getAction(state_, message_.event);
+		StateMachineArray::select(index_);
+		StateMachineArray::hsm.message(message_);
+		StateMachineArray::states[index_] = StateMachineArray::hsm.state;
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachineArray::message
+ * Description       : handle batch of user messages, one message for each hsm instance
+ * Parameters        :
+ *               tab : array of messages, message 'i' is handled by hsm instance 'i'
+ * Return            : none
+ ******************************************************************************/
 
-		if (action_ == nullptr)
-			return nullptr;
+	void message( const Message *tab_ )
+	{
+		const std::size_t count_ = StateMachineArray::states.size();
 
- 		State* target_ = std::visit(Visitor{message_}, action_->action);
+		if (StateMachineArray::jumps.empty())
+		{
+			for (std::size_t index_ = 0; index_ < count_; index_++)
+				StateMachineArray::message(index_, tab_[index_]);
+			return;
+		}
 
-		if (target_ == nullptr)
-			target_ = state_;
+		unsigned next_[Block];
+		for (std::size_t first_ = 0; first_ < count_; first_ += Block)
+		{
+			const std::size_t size_ = std::min(Block, count_ - first_);
+			StateMachineArray::gather(first_, size_, tab_ + first_, next_);
 
- 		return target_;
+			for (std::size_t item_ = 0; item_ < size_; item_++)
+			{
+				if (next_[item_] != Definition::none)
+					StateMachineArray::jump(first_ + item_, next_[item_], tab_[first_ + item_]);
+				else
+					StateMachineArray::message(first_ + item_, tab_[first_ + item_]);
+			}
+		}
 	}
 
 /******************************************************************************
- * Name              : hsm::Action::link
- * Description       : link hsm state action to the owner state action queue
- * Parameters        : none
+ * Name              : hsm::StateMachineArray::message
+ * Description       : handle batch of user messages addressed to given hsm instances
+ * Parameters        :
+ *               idx : array of hsm instance indexes
+ *               tab : array of messages, message 'i' is handled by hsm instance 'idx[i]'
+ *             count : number of messages
  * Return            : none
- * Note              : for internal use
  ******************************************************************************/
 
-	void link()
+	void message( const std::size_t *idx_, const Message *tab_, std::size_t count_ )
 	{
-		if (Action::next == nullptr)
+		for (std::size_t item_ = 0; item_ < count_; item_++)
 		{
-			Action::next = Action::owner.getQueue();
-			Action::owner.setQueue(this);
+			assert(idx_[item_] < StateMachineArray::states.size());
+
+			unsigned next_ = StateMachineArray::jump(StateMachineArray::states[idx_[item_]], tab_[item_].event);
+			if (next_ != Definition::none)
+				StateMachineArray::jump(idx_[item_], next_, tab_[item_]);
+			else
+				StateMachineArray::message(idx_[item_], tab_[item_]);
 		}
 	}
 
-	friend struct StateMachine;
-};
+/******************************************************************************
+ * Name              : hsm::StateMachineArray::save
+ * Description       : copy the snapshots of all hsm instances (indexes of current states) to the given array
+ * Parameters        :
+ *               tab : array of 'size()' snapshots
+ * Return            : none
+ ******************************************************************************/
+
+	void save( unsigned *tab_ ) const
+	{
+		std::memcpy(tab_, StateMachineArray::states.data(), StateMachineArray::states.size() * sizeof(unsigned));
+	}
 
 /******************************************************************************
- *
- * Class             : StateMachine
- *
- * Description       : hierarchical state machine object
- *
- * Constructor parameters
- *                   : none
- *
+ * Name              : hsm::StateMachineArray::restore
+ * Description       : set the current states of all hsm instances from the given array of snapshots
+ *                     no event handlers (Entry, Init) are called
+ * Parameters        :
+ *               tab : array of 'size()' snapshots
+ * Return            : none
  ******************************************************************************/
 
-struct StateMachine
-{
-	StateMachine():                                  tab{}     {}
-	StateMachine( const std::vector<Action>& tab_ ): tab{tab_} {}
+	void restore( const unsigned *tab_ )
+	{
+		assert(StateMachineArray::hsm.def->ready);
 
-	StateMachine( StateMachine&& ) = default;
-	StateMachine( const StateMachine& ) = delete;
-	StateMachine& operator=( StateMachine&& ) = delete;
-	StateMachine& operator=( const StateMachine& ) = delete;
+		std::memcpy(StateMachineArray::states.data(), tab_, StateMachineArray::states.size() * sizeof(unsigned));
+		for ([[maybe_unused]] unsigned state_: StateMachineArray::states)
+			assert(state_ == Definition::none || state_ < StateMachineArray::hsm.def->states.size());
+	}
 
 /******************************************************************************
- * Name              : hsm::StateMachine::add
- * Description       : add set of hsm actions to the hsm
- *               tab : std::vector with set of hsm actions
- * Return            : none
+ * Name              : hsm::StateMachineArray::save
+ * Description       : get the snapshot of given hsm instance
+ * Parameters        :
+ *             index : index of hsm instance
+ * Return            : index of the current state or 'Definition::none' if the hsm instance is stopped
  ******************************************************************************/
 
-	void add( const std::vector<Action>& tab_ )
+	unsigned save( std::size_t index_ ) const
 	{
-		std::copy(std::begin(tab_), std::end(tab_), std::back_inserter(StateMachine::tab));
+		assert(index_ < StateMachineArray::states.size());
+
+		return StateMachineArray::states[index_];
 	}
 
 /******************************************************************************
- * Name              : hsm::StateMachine::add
- * Description       : add hsm action with given parameters to the hsm
+ * Name              : hsm::StateMachineArray::restore
+ * Description       : set the current state of given hsm instance from the snapshot
+ *                     no event handlers (Entry, Init) are called
  * Parameters        :
- *             owner : hsm action owner (State)
- *             event : hsm action event value
- *    handler, state : variant parameter for hsm action constructor
+ *             index : index of hsm instance
+ *             state : index of the current state returned by the function 'save'
  * Return            : none
- * Note              : declared and defined in header file
  ******************************************************************************/
 
-	template<class T>
-	void add( State& owner_, unsigned event_, T&& action_ )
+	void restore( std::size_t index_, unsigned state_ )
 	{
-		StateMachine::tab.emplace_back(owner_, event_, action_);
+		assert(index_ < StateMachineArray::states.size());
+		assert(StateMachineArray::hsm.def->ready);
+		assert(state_ == Definition::none || state_ < StateMachineArray::hsm.def->states.size());
+
+		StateMachineArray::states[index_] = state_;
 	}
 
+#ifdef HSM_METRICS
 /******************************************************************************
- * Name              : hsm::StateMachine::start
- * Description       : start hierarchical state machine
+ * Name              : hsm::StateMachineArray::attach
+ * Description       : attach the performance counters shared by all hsm instances
+ *                     transitions resolved by the jump table are counted as well
  * Parameters        :
- *              init : initial hsm state
+ *           metrics : performance counters (Metrics)
  * Return            : none
+ * Note              : available with HSM_METRICS defined
  ******************************************************************************/
 
-	void start( State& init_ )
+	void attach( Metrics& metrics_ )
 	{
-		assert(StateMachine::state == nullptr);
-		assert(StateMachine::state == init_.parent);
+		StateMachineArray::hsm.attach(metrics_);
+	}
 
-		if (StateMachine::state == nullptr)
-		{
-			for (auto& action_: StateMachine::tab)
-				action_.link();
+/******************************************************************************
+ * Name              : hsm::StateMachineArray::snapshot
+ * Description       : get the current values of the attached performance counters
+ * Parameters        : none
+ * Return            : snapshot of the performance counters
+ * Note              : available with HSM_METRICS defined
+ ******************************************************************************/
 
-			StateMachine::transition(&init_, {});
-		}
+	Metrics::Snapshot snapshot() const
+	{
+		return StateMachineArray::hsm.snapshot();
 	}
 
+#endif
+/* -------------------------------------------------------------------------- */
+
+	private:
+	static constexpr std::size_t Block = 64; // number of batch messages looked up at once
+
+	StateMachine hsm;            // hsm object handling messages of all instances
+	std::pmr::vector<unsigned> states;// current state of each hsm instance
+	std::size_t index{};         // index of hsm instance handling the message
+	std::pmr::vector<unsigned> jumps; // final state of the pure transition for each state and event value
+	                             // or 'none' if the message must be handled by the hsm object
+	unsigned range{};            // number of event values in each row of the jump table
+#if defined(HSM_AVX2) && HSM_AVX2
+	bool wide{};                 // the jump table is looked up with AVX2 gathers
+#endif
+
 /******************************************************************************
- * Name              : hsm::StateMachine::message
- * Description       : handle given user message
+ * Name              : hsm::StateMachineArray::defers
+ * Description       : check if the definition has any action deferring the user event
+ *                     the array has no deferral queue, so deferred events are not allowed
  * Parameters        :
- *               msg : message
- * Return            : none
+ *               def : hsm definition
+ * Return            : definition has deferred events
+ * Note              : for internal use
  ******************************************************************************/
 
-	void message( const Message& message_ )
+	static bool defers( const Definition& def_ )
 	{
-		assert(StateMachine::state != nullptr);
-		assert(message_.event == Event::Stop || message_.event >= Event::User);
+		for (unsigned action_ = 0; action_ < def_.getActions(); action_++)
+			if (def_.isDeferred(action_))
+				return true;
 
-		if      (message_.event >= Event::User) StateMachine::eventHandler({message_, this});
-		else if (message_.event == Event::Stop) StateMachine::transition(nullptr, {});
+		return false;
 	}
 
 /******************************************************************************
- * Name              : hsm::StateMachine::transition
- * Description       : set the transition target state from the event handler
- * Parameters        :
- *            target : transition target state
+ * Name              : hsm::StateMachineArray::compile
+ * Description       : build the jump table of pure transitions
+ *                     the transition is pure if it's resolved to the unguarded direct transition
+ *                     and no Exit, Entry and Init event handlers are called on the way to the final state;
+ *                     unhandled and consumed messages leave the state unchanged
+ *                     the table is built only for the definition with dense event values
+ * Parameters        : none
  * Return            : none
+ * Note              : for internal use
  ******************************************************************************/
 
-	void transition( State& target_ )
+	void compile()
 	{
-		StateMachine::target = &target_;
-	}
+		const Definition& def_ = *StateMachineArray::hsm.def;
+		const std::size_t size_ = def_.states.size() * def_.range;
 
-/* -------------------------------------------------------------------------- */
+		if (!def_.ready || size_ == 0 || size_ > INT32_MAX)
+			return;
 
-	private:
-	State  *state{}; // current hsm state
-	State *target{}; // the transition target set by the user in event handler
-	                 // procedure with the function 'transition'
-	std::vector<Action> tab; // set of hsm actions
+		StateMachineArray::range = def_.range;
+		StateMachineArray::jumps.assign(size_, Definition::none);
+		for (unsigned state_ = 0; state_ < def_.states.size(); state_++)
+			for (unsigned event_ = Event::User; event_ < def_.range; event_++)
+				StateMachineArray::jumps[state_ * def_.range + event_] = StateMachineArray::follow(state_, def_.getColumn(event_));
+#if defined(HSM_AVX2) && HSM_AVX2
+		StateMachineArray::wide = __builtin_cpu_supports("avx2");
+#endif
+	}
 
 /******************************************************************************
- * Name              : hsm::StateMachine::callAction
- * Description       : try to handle the message for the given hsm state
+ * Name              : hsm::StateMachineArray::follow
+ * Description       : get the final state of the pure transition
  * Parameters        :
- *             state : state handling the event
- *           message : received message
- * Return            : assigned action exist; message has been handled
+ *             state : index of the current state
+ *            column : dispatch table column of the user event
+ * Return            : index of the final state or 'none' if the transition is not pure
  * Note              : for internal use
  ******************************************************************************/
 
-	bool callAction( State *state_, const Message& message_ )
+	unsigned follow( unsigned state_, unsigned column_ ) const
 	{
-		StateMachine::target = state_;
+		const Definition& def_ = *StateMachineArray::hsm.def;
+		unsigned action_ = def_.getAction(state_, column_);
 
-		State* target_ = Action::callHandler(state_, message_);
+		if (action_ == Definition::none)
+			return state_;
 
-		if (target_ == nullptr)
-			return false;
+		for (;;)
+		{
+			if (def_.isGuarded(action_))
+				return Definition::none;
 
-		if (target_ == state_)
-			target_ = StateMachine::target;
+			const Definition::Link link_ = def_.getLink(action_);
 
-		if (target_ == state_)
-			return true;
+			if (link_.target == Definition::none)
+				return Definition::none;
 
-		assert(message_.event >= Event::User || target_->parent == state_);
-		StateMachine::transition(target_, message_);
+			if (link_.target == link_.owner)
+				return state_;
 
-		return true;
+			const unsigned root_ = def_.getRoot(state_, link_.target);
+
+			for (unsigned prev_ = state_; prev_ != root_; prev_ = def_.getPrev(prev_))
+				if (def_.getAction(prev_, Event::Exit - Event::Exit) != Definition::none)
+					return Definition::none;
+
+			for (unsigned next_ = link_.target; next_ != root_; next_ = def_.getPrev(next_))
+				if (def_.getAction(next_, Event::Entry - Event::Exit) != Definition::none)
+					return Definition::none;
+
+			state_ = link_.target;
+			action_ = def_.getAction(state_, Event::Init - Event::Exit);
+
+			if (action_ == Definition::none)
+				return state_;
+		}
 	}
 
 /******************************************************************************
- * Name              : hsm::StateMachine::transition
- * Description       : do the transition to the given target state
+ * Name              : hsm::StateMachineArray::jump
+ * Description       : look up the final state of the pure transition
  * Parameters        :
- *              next : transition target state
- *           message : handled message
- * Return            : none
+ *             state : index of the current state
+ *             event : event value
+ * Return            : index of the final state or 'none' if the message must be handled by the hsm object
  * Note              : for internal use
  ******************************************************************************/
 
-	void transition( State *next_, const Message& message_ )
+	unsigned jump( unsigned state_, unsigned event_ ) const
 	{
-		State *root_ = State::getRoot(StateMachine::state, next_);
+		if (state_ == Definition::none || event_ >= StateMachineArray::range)
+			return Definition::none;
 
-		while (StateMachine::state != root_)
+		return StateMachineArray::jumps[state_ * StateMachineArray::range + event_];
+	}
+
+/******************************************************************************
+ * Name              : hsm::StateMachineArray::jump
+ * Description       : set the final state of the pure transition of given hsm instance
+ *                     the transition is recorded by the trace and the attached performance counters
+ * Parameters        :
+ *             index : index of hsm instance
+ *              next : index of the final state found in the jump table
+ *               msg : handled message
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void jump( std::size_t index_, unsigned next_, [[maybe_unused]] const Message& message_ )
+	{
+#if defined(HSM_TRACE) || defined(HSM_METRICS)
+#ifndef HSM_TRACE
+		if (StateMachineArray::hsm.metrics != nullptr)
+#endif
 		{
-			Action::callHandler(StateMachine::state, {message_, Event::Exit});
-			StateMachine::state = State::getPrev(StateMachine::state);
+			StateMachineArray::select(index_);
+			StateMachineArray::hsm.jump(message_);
+
+			assert(StateMachineArray::hsm.state == next_);
 		}
+#endif
+		StateMachineArray::states[index_] = next_;
+	}
 
-		while (StateMachine::state != next_)
+/******************************************************************************
+ * Name              : hsm::StateMachineArray::gather
+ * Description       : look up the final states of pure transitions for the block of hsm instances
+ *                     uses AVX2 gathers if supported by the cpu
+ * Parameters        :
+ *             first : index of the first hsm instance
+ *              size : number of hsm instances (at most 'Block')
+ *               tab : array of messages, message 'i' is handled by hsm instance 'first + i'
+ *              next : array of final states (Definition::none if the message must be handled by the hsm object)
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void gather( std::size_t first_, std::size_t size_, const Message *tab_, unsigned *next_ ) const
+	{
+		std::size_t item_ = 0;
+#if defined(HSM_AVX2) && HSM_AVX2
+		if (StateMachineArray::wide)
+			item_ = StateMachineArray::gatherWide(first_, size_, tab_, next_);
+#endif
+		for (; item_ < size_; item_++)
+			next_[item_] = StateMachineArray::jump(StateMachineArray::states[first_ + item_], tab_[item_].event);
+	}
+
+#if defined(HSM_AVX2) && HSM_AVX2
+/******************************************************************************
+ * Name              : hsm::StateMachineArray::gatherWide
+ * Description       : look up the final states of pure transitions for the block of hsm instances with AVX2 gathers,
+ *                     eight instances at once; compiled for AVX2 regardless of the build flags,
+ *                     called only if the cpu supports AVX2
+ * Parameters        :
+ *             first : index of the first hsm instance
+ *              size : number of hsm instances (at most 'Block')
+ *               tab : array of messages, message 'i' is handled by hsm instance 'first + i'
+ *              next : array of final states (Definition::none if the message must be handled by the hsm object)
+ * Return            : number of hsm instances looked up (multiple of eight)
+ * Note              : for internal use
+ ******************************************************************************/
+
+	__attribute__((target("avx2")))
+	std::size_t gatherWide( std::size_t first_, std::size_t size_, const Message *tab_, unsigned *next_ ) const
+	{
+		static_assert(sizeof(Message) % sizeof(int) == 0 && alignof(Message) >= alignof(int));
+
+		constexpr int stride_ = static_cast<int>(sizeof(Message) / sizeof(int));
+		const __m256i none_   = _mm256_set1_epi32(-1);
+		const __m256i range_  = _mm256_set1_epi32(static_cast<int>(StateMachineArray::range));
+		const __m256i last_   = _mm256_set1_epi32(static_cast<int>(StateMachineArray::range - 1));
+		const __m256i offset_ = _mm256_setr_epi32(0, stride_, 2 * stride_, 3 * stride_, 4 * stride_, 5 * stride_, 6 * stride_, 7 * stride_);
+		const int    *jumps_  = reinterpret_cast<const int *>(StateMachineArray::jumps.data());
+
+		std::size_t item_ = 0;
+		for (; item_ + 8 <= size_; item_ += 8)
 		{
-			StateMachine::state = State::getNext(StateMachine::state, next_);
-			Action::callHandler(StateMachine::state, {message_, Event::Entry});
+			__m256i state_ = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&StateMachineArray::states[first_ + item_]));
+			__m256i event_ = _mm256_i32gather_epi32(reinterpret_cast<const int *>(&tab_[item_].event), offset_, 4);
+			__m256i valid_ = _mm256_andnot_si256(_mm256_cmpeq_epi32(state_, none_), _mm256_cmpeq_epi32(_mm256_min_epu32(event_, last_), event_));
+			__m256i index_ = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_and_si256(state_, valid_), range_), _mm256_and_si256(event_, valid_));
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(&next_[item_]), _mm256_mask_i32gather_epi32(none_, jumps_, index_, valid_, 4));
 		}
 
-		StateMachine::callAction(StateMachine::state, {message_, Event::Init});
+		return item_;
 	}
 
+#endif
 /******************************************************************************
- * Name              : hsm::StateMachine::eventHandler
- * Description       : internal event handler procedure
+ * Name              : hsm::StateMachineArray::select
+ * Description       : load the state of given hsm instance to the hsm object
  * Parameters        :
- *           message : received message
+ *             index : index of hsm instance
  * Return            : none
  * Note              : for internal use
  ******************************************************************************/
 
-	void eventHandler( const Message& message_ )
+	void select( std::size_t index_ )
 	{
-		State *state_ = StateMachine::state;
+		assert(index_ < StateMachineArray::states.size());
 
-		while (state_ != nullptr && !StateMachine::callAction(state_, message_))
-			state_ = state_->parent;
+		StateMachineArray::index = index_;
+		StateMachineArray::hsm.state = StateMachineArray::states[index_];
 	}
 };
 
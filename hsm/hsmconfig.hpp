@@ -2,8 +2,8 @@
 
     @file    hsmconfig.hpp
     @author  Rajmund Szymanski
-    @date    16.08.2022
-    @brief   This file contains message class definition for hsm.
+    @date    14.10.2026
+    @brief   This file contains configuration and message class definition for hsm.
 
  ******************************************************************************
 
@@ -32,19 +32,132 @@
 #ifndef __HSMCONFIG_HPP
 #define __HSMCONFIG_HPP
 
+#include <memory_resource>
+#include <cassert>
+#include <cstddef>
+
+/* -------------------------------------------------------------------------- */
+
+// define the capacity (in bytes) of the callable object stored in the event handler
+// to use non-allocating hsm::InplaceHandler instead of std::function as hsm::Handler
+
+//#define HSM_HANDLER_SIZE 32
+
+// define to store the compiled hsm definition with 16-bit indices
+// (less than 65535 states, actions and entries of all state paths)
+
+//#define HSM_SMALL_INDEX
+
+// define to add the borrowed typed payload to the message (hsm::Message::get);
+// the message grows from two to four words
+
+//#define HSM_PAYLOAD
+
+// define the capacity (in records, a power of two) of the per-thread trace ring buffer
+// to record hsm actions, transitions and system event handlers (see hsmtrace.hpp)
+// optionally define the timestamp source (default: the cycle counter) and the duration of its tick in picoseconds
+// and the size of the static pool of trace buffers (default: the heap, 1 in the freestanding profile)
+
+//#define HSM_TRACE 1024
+//#define HSM_TRACE_CLOCK() __rdtsc()
+//#define HSM_TRACE_TICK 0
+//#define HSM_TRACE_BUFFERS 4
+
+// define as 0 to disable the AVX2 lookup of the jump table of hsm::StateMachineArray;
+// by default it's compiled on x86 with GCC compatible compilers and selected at run time if the cpu supports AVX2
+
+//#define HSM_AVX2 0
+
+// define to enable the performance counters attached to the hsm (see hsmmetrics.hpp)
+// optionally define the time source (in nanoseconds)
+
+//#define HSM_METRICS
+//#define HSM_METRICS_CLOCK() my_clock_ns()
+
+// define the size (in bytes) of the static arena to build the freestanding profile
+// (no heap, compiled with -fno-exceptions -fno-rtti, see the 'embedded' target of the makefile):
+// hsm::Handler is the pointer to function, the set of hsm actions is std::initializer_list
+// and the default memory resource of the hsm objects is the static arena
+// optionally define the cycle counter used by the dispatch latency report of the example
+
+//#define HSM_FREESTANDING 16384
+//#define HSM_CYCLES() DWT->CYCCNT
+
+/* -------------------------------------------------------------------------- */
+
 namespace hsm {
 
 struct StateMachine; // forward declaration
 
+#ifdef HSM_FREESTANDING
+/******************************************************************************
+ *
+ * Class             : ArenaExhausted
+ *
+ * Description       : upstream memory resource of the static arena in the freestanding profile
+ *                     any request reaching it is fatal: fails the assertion or traps,
+ *                     never throws std::bad_alloc (code compiled with -fno-exceptions)
+ * Note              : for internal use
+ *
+ ******************************************************************************/
+
+struct ArenaExhausted : std::pmr::memory_resource
+{
+	static void operator delete( void *, std::size_t ) {} // static object only, keeps the deleting destructor off the heap
+
+	private:
+	void *do_allocate( std::size_t, std::size_t ) override
+	{
+		assert(!"hsm: the static arena is exhausted");
+		__builtin_trap();
+	}
+
+	void do_deallocate( void *, std::size_t, std::size_t ) override {}
+
+	bool do_is_equal( const std::pmr::memory_resource& other_ ) const noexcept override
+	{
+		return this == &other_;
+	}
+};
+
+#endif
+/******************************************************************************
+ * Name              : hsm::defaultResource
+ * Description       : get the default memory resource of the hsm objects
+ *                     in the freestanding profile the static arena of HSM_FREESTANDING bytes
+ *                     is used: the storage is never released and the exhausted arena is fatal
+ * Parameters        : none
+ * Return            : std::pmr::get_default_resource() or the static arena
+ * Note              : the static arena is not synchronized; create the hsm objects in one thread
+ ******************************************************************************/
+
+inline std::pmr::memory_resource *defaultResource()
+{
+#ifdef HSM_FREESTANDING
+	alignas(std::max_align_t)
+	static unsigned char arena_[HSM_FREESTANDING];
+	static ArenaExhausted upstream_;
+	static std::pmr::monotonic_buffer_resource resource_{arena_, sizeof(arena_), &upstream_};
+
+	return &resource_;
+#else
+	return std::pmr::get_default_resource();
+#endif
+}
+
 /******************************************************************************
  *
  * Class             : Message
  *
  * Description       : hierarchical state machine message object
  *                     reference to Message object is passed to event handler
+ *                     with HSM_PAYLOAD defined the message can borrow a typed payload: only the pointer is copied,
+ *                     system events (Exit, Entry, Init) of the transition see the same payload
+ *                     the payload must outlive the handling of the message (also in the queue)
  *
  * Constructor parameters
  *             event : event value
+ *           payload : payload object of any type (not copied, must not be a temporary; HSM_PAYLOAD only)
  *
  ******************************************************************************/
 
@@ -52,14 +165,46 @@ struct Message
 {
 	constexpr Message() {}
 	constexpr Message( unsigned event_ ): Message() { event = event_; }
+#ifdef HSM_PAYLOAD
+	template<class T>
+	constexpr Message( unsigned event_, const T& payload_ ): Message(event_) { payload = &payload_; type = &Message::id<T>; }
+	template<class T>
+	Message( unsigned, const T&& ) = delete; // the payload is borrowed, a temporary would dangle
+#endif
 	constexpr Message( const Message& source_, unsigned event_ ): Message(source_) { event = event_; }
 	constexpr Message( const Message& source_, StateMachine *hsm_ ): Message(source_) { hsm = hsm_; }
 //	TODO: put here other constructors
 
+#ifdef HSM_PAYLOAD
+/******************************************************************************
+ * Name              : hsm::Message::get
+ * Description       : get the payload of the message
+ * Parameters        : none
+ * Return            : pointer to the payload or nullptr if the message has no payload of the given type
+ * Note              : declared and defined in header file; available with HSM_PAYLOAD defined
+ ******************************************************************************/
+
+	template<class T>
+	const T* get() const
+	{
+		return Message::type == &Message::id<T> ? static_cast<const T *>(Message::payload) : nullptr;
+	}
+
+#endif
 	StateMachine *hsm{}; // pointer to the hsm
 	unsigned    event{}; // event value
+#ifdef HSM_PAYLOAD
+	const void *payload{}; // borrowed payload
+	const void *type{};    // payload type tag
+#endif
 
 //	TODO: put here other data
+#ifdef HSM_PAYLOAD
+
+	private:
+	template<class T>
+	static constexpr char id{}; // unique address for each payload type
+#endif
 };
 
 }     //  namespace hsm
@@ -0,0 +1,140 @@
+/******************************************************************************
+
+    @file    hsmcoro.hpp
+    @author  Rajmund Szymanski
+    @date    14.10.2026
+    @brief   This file contains definitions of the coroutine event handlers for hsm.
+
+ ******************************************************************************
+
+   Copyright (c) 2018-2026 Rajmund Szymanski. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+
+ ******************************************************************************/
+
+
+#ifndef __HSMCORO_HPP
+#define __HSMCORO_HPP
+
+#include <coroutine>
+#include <exception>
+#include <type_traits>
+#include <utility>
+#include "hsm.hpp"
+
+namespace hsm {
+
+/******************************************************************************
+ *
+ * Class             : Task
+ *
+ * Description       : detached coroutine returned by the event handler of the user message
+ *                     the first suspension of the coroutine suspends the handling of the message,
+ *                     the hsm stays in the current state and queues all incoming messages;
+ *                     the transition set with the function 'transition' is done when the coroutine returns,
+ *                     then the queued messages are handled with run-to-completion semantics
+ *                     the coroutine which completes without suspension works like the ordinary handler
+ *                     the record of the suspended message is held by the coroutine frame
+ *
+ * Note              : the event handler must take the message by value, e.g. [&]( hsm::Message msg ) -> hsm::Task { ... }
+ *                     the queue must be attached to the hsm; the hsm must not have orthogonal regions
+ *                     the Exit, Entry and Init event handlers must not suspend
+ *                     the queue must hold all messages received while the handling is suspended
+ *                     the awaited object must be the awaiter (await_ready / await_suspend / await_resume)
+ *                     and it must resume the coroutine on the thread running the hsm
+ *
+ ******************************************************************************/
+
+struct Task
+{
+	struct promise_type
+	{
+		promise_type( const Message& message_ ): hsm{message_.hsm} {}
+		template<class C>
+		promise_type( C&, const Message& message_ ): hsm{message_.hsm} {}
+
+		Task get_return_object() { return {}; }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void unhandled_exception() { std::terminate(); }
+
+/******************************************************************************
+ * Name              : hsm::Task::promise_type::return_void
+ * Description       : complete the handling of the suspended message
+ * Parameters        : none
+ * Return            : none
+ ******************************************************************************/
+
+		void return_void()
+		{
+			if (promise_type::suspended)
+				promise_type::hsm->resume();
+		}
+
+/******************************************************************************
+ * Name              : hsm::Task::promise_type::await_transform
+ * Description       : wrap the awaited object to suspend the handling of the message
+ *                     before the first suspension of the coroutine
+ * Parameters        :
+ *            object : awaited object
+ * Return            : wrapped awaiter
+ ******************************************************************************/
+
+		template<class A>
+		auto await_transform( A&& object_ ) { return Awaiter<A>{std::forward<A>(object_), this}; }
+
+/* -------------------------------------------------------------------------- */
+
+		private:
+		StateMachine *hsm;                   // hsm instance handling the message
+		StateMachine::Suspension suspension; // record of the suspended message kept by the hsm
+		bool suspended{};                    // the handling of the message has been suspended
+
+		template<class A>
+		struct Awaiter
+		{
+			A object;               // awaited object (reference to the lvalue)
+			promise_type *promise;  // promise of the awaiting coroutine
+
+			bool await_ready() { return Awaiter::object.await_ready(); }
+			decltype(auto) await_resume() { return Awaiter::object.await_resume(); }
+
+			template<class P>
+			auto await_suspend( std::coroutine_handle<P> handle_ )
+			{
+				if (!Awaiter::promise->suspended)
+				{
+					assert(Awaiter::promise->hsm != nullptr);
+
+					Awaiter::promise->suspended = true;
+					Awaiter::promise->hsm->suspend(Awaiter::promise->suspension);
+				}
+
+				return Awaiter::object.await_suspend(handle_);
+			}
+		};
+	};
+};
+
+/* -------------------------------------------------------------------------- */
+
+}     //  namespace hsm
+
+#endif//__HSMCORO_HPP
@@ -0,0 +1,610 @@
+/******************************************************************************
+
+    @file    hsmenum.hpp
+    @author  Rajmund Szymanski
+    @date    14.10.2026
+    @brief   This file contains definitions for hsm dispatched by the event enumeration.
+
+ ******************************************************************************
+
+   Copyright (c) 2018-2026 Rajmund Szymanski. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+
+ ******************************************************************************/
+
+
+#ifndef __HSMENUM_HPP
+#define __HSMENUM_HPP
+
+#include <algorithm>
+#include <array>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <variant>
+#include <vector>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include "hsm.hpp"
+
+namespace hsm {
+
+template<class E, std::size_t N>
+struct EnumStateMachine; // forward declaration
+
+/******************************************************************************
+ *
+ * Class             : EnumDefinition
+ *
+ * Description       : hsm definition object for the event enumeration known at compile time
+ *                     each state has its own dispatch table sized exactly to the number of events
+ *                     and the bitmask of events handled by the state itself;
+ *                     user events are resolved by the bit test up the precomputed path of ancestors
+ *                     can be shared by any number of hsm instances
+ *                     orthogonal regions, states with history and deferred events are not supported
+ *
+ * Template parameters
+ *                 E : event enumeration; all event values must be less than N
+ *                 N : number of event values (at most 64)
+ *
+ * Constructor parameters
+ *               tab : set of hsm actions
+ *          resource : memory resource providing all storage of the definition
+ *                     (default: hsm::defaultResource())
+ *
+ ******************************************************************************/
+
+template<class E, std::size_t N>
+struct EnumDefinition
+{
+	static_assert(std::is_enum_v<E>, "event type must be the enumeration");
+	static_assert(N > Event::Init && N <= 64, "number of events must fit into the bitmask");
+
+	static constexpr unsigned none = ~0U; // index of the 'no state' / 'no action'
+
+	using Mask = std::conditional_t<(N <= 32), std::uint32_t, std::uint64_t>;
+
+	EnumDefinition( const Table& tab_, std::pmr::memory_resource *resource_ = defaultResource() ):
+		EnumDefinition(resource_) { EnumDefinition::tab.reserve(tab_.size()); std::copy(std::begin(tab_), std::end(tab_), std::back_inserter(EnumDefinition::tab)); EnumDefinition::compile(); }
+#ifndef HSM_FREESTANDING
+	EnumDefinition( Table&& tab_, std::pmr::memory_resource *resource_ = defaultResource() ):
+		EnumDefinition(resource_) { EnumDefinition::tab.reserve(tab_.size()); std::move(std::begin(tab_), std::end(tab_), std::back_inserter(EnumDefinition::tab)); tab_.clear(); EnumDefinition::compile(); }
+#endif
+
+	EnumDefinition( EnumDefinition&& ) = delete;
+	EnumDefinition( const EnumDefinition& ) = delete;
+	EnumDefinition& operator=( EnumDefinition&& ) = delete;
+	EnumDefinition& operator=( const EnumDefinition& ) = delete;
+
+/******************************************************************************
+ * Name              : hsm::EnumDefinition::id
+ * Description       : get the id of the given hsm state
+ * Parameters        :
+ *             state : hsm state
+ * Return            : state id or 'none' if the state is not used by the hsm
+ ******************************************************************************/
+
+	unsigned id( const State& state_ ) const
+	{
+		return EnumDefinition::find(&state_);
+	}
+
+/* -------------------------------------------------------------------------- */
+
+	private:
+	explicit EnumDefinition( std::pmr::memory_resource *resource_ ):
+		tab(resource_), states(resource_), index(resource_), nodes(resource_), tree(resource_), links(resource_), lut(resource_) {}
+
+	struct Node
+	{
+		Mask     mask;   // events handled by the state itself
+		unsigned parent; // parent state
+		unsigned level;  // level in the hsm tree (1 for the top-level state)
+		unsigned path;   // position of the state path in the tree
+	};
+
+	struct Link
+	{
+		unsigned owner;  // action owner state
+		unsigned target; // direct transition target state or 'none' for the event handler
+		unsigned next;   // next action of the owner state and event, evaluated when the guard fails
+	};
+
+	std::pmr::vector<Action> tab;             // set of hsm actions
+	std::pmr::vector<const State *> states;   // hsm states, each after its parent
+	std::pmr::vector<std::pair<const State *, unsigned>> index; // hsm states sorted by address
+	std::pmr::vector<Node> nodes;             // state tree
+	std::pmr::vector<unsigned> tree;          // path of ancestors of each state, from the top-level state
+	std::pmr::vector<Link> links;             // actions
+	std::pmr::vector<std::array<unsigned, N>> lut; // first action of each state and event
+
+/******************************************************************************
+ * Name              : hsm::EnumDefinition::compile
+ * Description       : build the state tree and dispatch tables of the hsm definition
+ *                     guarded actions of the state and event are chained in order
+ *                     before the last unguarded action
+ * Parameters        : none
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void compile()
+	{
+		std::pmr::unordered_set<const State *> inserted_(EnumDefinition::tab.get_allocator().resource()); // states already inserted
+		inserted_.reserve(EnumDefinition::tab.size());
+		for (auto& action_: EnumDefinition::tab)
+		{
+			EnumDefinition::insert(&action_.owner, inserted_);
+			if (std::holds_alternative<State*>(action_.action))
+				EnumDefinition::insert(std::get<State*>(action_.action), inserted_);
+		}
+
+		for (unsigned state_ = 0; state_ < EnumDefinition::states.size(); state_++)
+			EnumDefinition::index.emplace_back(EnumDefinition::states[state_], state_);
+		std::sort(std::begin(EnumDefinition::index), std::end(EnumDefinition::index));
+
+		for (auto state_: EnumDefinition::states)
+		{
+			assert(state_->kind == State::Exclusive);
+
+			unsigned parent_ = EnumDefinition::find(state_->parent);
+			unsigned level_ = parent_ != none ? EnumDefinition::nodes[parent_].level + 1 : 1;
+			unsigned path_ = static_cast<unsigned>(EnumDefinition::tree.size());
+
+			EnumDefinition::tree.resize(path_ + level_);
+			EnumDefinition::nodes.push_back({ Mask{}, parent_, level_, path_ });
+			for (auto prev_ = state_; prev_ != nullptr; prev_ = prev_->parent)
+				EnumDefinition::tree[path_ + --level_] = EnumDefinition::find(prev_);
+		}
+
+		std::array<unsigned, N> empty_;
+		empty_.fill(none);
+		EnumDefinition::lut.assign(EnumDefinition::states.size(), empty_);
+		for (unsigned action_ = 0; action_ < EnumDefinition::tab.size(); action_++)
+		{
+			const Action& item_ = EnumDefinition::tab[action_];
+			unsigned owner_ = EnumDefinition::find(&item_.owner);
+			unsigned target_ = std::holds_alternative<State*>(item_.action) ? EnumDefinition::find(std::get<State*>(item_.action)) : none;
+
+			EnumDefinition::links.push_back({ owner_, target_, none });
+
+			assert(item_.event < N);
+			assert(item_.delay == 0); // state timeouts are not supported
+			assert(!std::holds_alternative<State*>(item_.action) || std::get<State*>(item_.action) != nullptr); // events cannot be deferred
+			assert(item_.guard == nullptr || item_.event == Event::Init || item_.event >= Event::User);
+
+			if (item_.guard != nullptr)
+				continue;
+
+			Node& node_ = EnumDefinition::nodes[owner_];
+			if (item_.event == Event::ALL)
+			{
+				EnumDefinition::lut[owner_].fill(action_);
+				node_.mask = static_cast<Mask>(~Mask{} >> (sizeof(Mask) * 8 - N));
+			}
+			else
+			if (item_.event >= Event::Exit)
+			{
+				EnumDefinition::lut[owner_][item_.event] = action_;
+				node_.mask |= Mask{1} << item_.event;
+			}
+		}
+
+		// guarded actions are chained in order before the unguarded action
+		for (unsigned action_ = static_cast<unsigned>(EnumDefinition::tab.size()); action_-- > 0;)
+		{
+			const Action& item_ = EnumDefinition::tab[action_];
+			if (item_.guard == nullptr)
+				continue;
+
+			Link& link_ = EnumDefinition::links[action_];
+			unsigned& entry_ = EnumDefinition::lut[link_.owner][item_.event];
+			link_.next = entry_;
+			entry_ = action_;
+			EnumDefinition::nodes[link_.owner].mask |= Mask{1} << item_.event;
+		}
+	}
+
+/******************************************************************************
+ * Name              : hsm::EnumDefinition::insert
+ * Description       : insert the given hsm state and its ancestors to the set of states
+ * Parameters        :
+ *             state : pointer to hsm state
+ *          inserted : hash set of the states already inserted
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void insert( const State *state_, std::pmr::unordered_set<const State *>& inserted_ )
+	{
+		if (state_ == nullptr || !inserted_.insert(state_).second)
+			return;
+
+		EnumDefinition::insert(state_->parent, inserted_);
+		EnumDefinition::states.push_back(state_);
+	}
+
+/******************************************************************************
+ * Name              : hsm::EnumDefinition::find
+ * Description       : find index of the given hsm state
+ * Parameters        :
+ *             state : pointer to hsm state
+ * Return            : hsm state index or 'none' if the state is not used by the hsm
+ * Note              : for internal use
+ ******************************************************************************/
+
+	unsigned find( const State *state_ ) const
+	{
+		auto item_ = std::lower_bound(std::begin(EnumDefinition::index), std::end(EnumDefinition::index), std::make_pair(state_, 0U));
+
+		if (item_ == std::end(EnumDefinition::index) || item_->first != state_)
+			return none;
+
+		return item_->second;
+	}
+
+/******************************************************************************
+ * Name              : hsm::EnumDefinition::resolve
+ * Description       : get the action handling the given message in the given state
+ *                     the system event is handled only by the state itself,
+ *                     the user event is handled by the nearest state (starting from the given one)
+ *                     having the event bit set in its mask and the action with the passing guard
+ * Parameters        :
+ *             state : hsm state index
+ *             event : event value
+ *           message : received message
+ * Return            : index of the action or 'none' if the message is not handled
+ * Note              : for internal use
+ ******************************************************************************/
+
+	unsigned resolve( unsigned state_, unsigned event_, const Message& message_ ) const
+	{
+		const Mask bit_ = Mask{1} << event_;
+
+		for (; state_ != none; state_ = EnumDefinition::nodes[state_].parent)
+		{
+			if (EnumDefinition::nodes[state_].mask & bit_)
+			{
+				unsigned action_ = EnumDefinition::lut[state_][event_];
+				while (action_ != none && EnumDefinition::tab[action_].guard != nullptr && !EnumDefinition::tab[action_].guard(message_))
+					action_ = EnumDefinition::links[action_].next;
+
+				if (action_ != none)
+					return action_;
+			}
+
+			if (event_ < Event::User)
+				break;
+		}
+
+		return none;
+	}
+
+/******************************************************************************
+ * Name              : hsm::EnumDefinition::callHandler
+ * Description       : invoke the event handler of the given action
+ * Parameters        :
+ *            action : index of the action
+ *           message : received message
+ * Return            : the action has the event handler
+ * Note              : for internal use
+ ******************************************************************************/
+
+	bool callHandler( unsigned action_, const Message& message_ ) const
+	{
+		if (EnumDefinition::links[action_].target != none)
+			return false;
+
+		std::get<Handler>(EnumDefinition::tab[action_].action)(message_);
+		return true;
+	}
+
+/******************************************************************************
+ * Name              : hsm::EnumDefinition::getRoot
+ * Description       : get the nearest common ancestor of the given hsm states
+ * Parameters        :
+ *             state : hsm state index
+ *             other : hsm state index
+ * Return            : index of the common ancestor or 'none' if the states have no common ancestor
+ * Note              : for internal use
+ ******************************************************************************/
+
+	unsigned getRoot( unsigned state_, unsigned other_ ) const
+	{
+		if (state_ == none || other_ == none)
+			return none;
+
+		const unsigned *state_path_ = &EnumDefinition::tree[EnumDefinition::nodes[state_].path];
+		const unsigned *other_path_ = &EnumDefinition::tree[EnumDefinition::nodes[other_].path];
+		unsigned level_ = std::min(EnumDefinition::nodes[state_].level, EnumDefinition::nodes[other_].level);
+
+		while (level_ > 0 && state_path_[level_ - 1] != other_path_[level_ - 1])
+			level_--;
+
+		return level_ > 0 ? state_path_[level_ - 1] : none;
+	}
+
+/******************************************************************************
+ * Name              : hsm::EnumDefinition::getPrev
+ * Description       : get the parent of the hsm state
+ * Parameters        :
+ *             state : hsm state index
+ * Return            : parent state index
+ * Note              : for internal use
+ ******************************************************************************/
+
+	unsigned getPrev( unsigned state_ ) const
+	{
+		return EnumDefinition::nodes[state_].parent;
+	}
+
+/******************************************************************************
+ * Name              : hsm::EnumDefinition::getNext
+ * Description       : get child state in the child branch
+ * Parameters        :
+ *             state : hsm state index
+ *              sign : index of the hsm state in the child branch
+ * Return            : child state index
+ * Note              : for internal use
+ ******************************************************************************/
+
+	unsigned getNext( unsigned state_, unsigned sign_ ) const
+	{
+		return EnumDefinition::tree[EnumDefinition::nodes[sign_].path + (state_ != none ? EnumDefinition::nodes[state_].level : 0)];
+	}
+
+	friend struct EnumStateMachine<E, N>;
+};
+
+/******************************************************************************
+ *
+ * Class             : EnumStateMachine
+ *
+ * Description       : hsm object dispatched by the event enumeration known at compile time
+ *                     the event value is used directly as the index of the state dispatch table
+ *                     the 'hsm' field of the message passed to the event handler identifies the hsm object,
+ *                     which is not hsm::StateMachine; get it with the function 'from'
+ *                     to call the function 'transition'
+ *
+ * Template parameters
+ *                 E : event enumeration; all event values must be less than N
+ *                 N : number of event values (at most 64)
+ *
+ * Constructor parameters
+ *               def : hsm definition
+ *
+ ******************************************************************************/
+
+template<class E, std::size_t N>
+struct EnumStateMachine
+{
+	using Definition = EnumDefinition<E, N>;
+
+	EnumStateMachine( const Definition& def_ ): def{&def_} {}
+
+	EnumStateMachine( EnumStateMachine&& ) = delete;
+	EnumStateMachine( const EnumStateMachine& ) = delete;
+	EnumStateMachine& operator=( EnumStateMachine&& ) = delete;
+	EnumStateMachine& operator=( const EnumStateMachine& ) = delete;
+
+/******************************************************************************
+ * Name              : hsm::EnumStateMachine::start
+ * Description       : start hierarchical state machine
+ * Parameters        :
+ *              init : initial hsm state
+ * Return            : none
+ ******************************************************************************/
+
+	void start( State& init_ )
+	{
+		unsigned next_ = EnumStateMachine::getState(&init_);
+
+		assert(EnumStateMachine::state == Definition::none);
+		assert(EnumStateMachine::def->getPrev(next_) == Definition::none);
+
+		if (EnumStateMachine::state == Definition::none)
+			EnumStateMachine::transition(next_, Definition::none, {Message{}, EnumStateMachine::self()});
+	}
+
+/******************************************************************************
+ * Name              : hsm::EnumStateMachine::message
+ * Description       : handle given user event
+ * Parameters        :
+ *             event : event value
+ * Return            : none
+ ******************************************************************************/
+
+	void message( E event_ )
+	{
+		EnumStateMachine::message(Message{static_cast<unsigned>(event_)});
+	}
+
+/******************************************************************************
+ * Name              : hsm::EnumStateMachine::message
+ * Description       : handle given user message
+ * Parameters        :
+ *               msg : message
+ * Return            : none
+ ******************************************************************************/
+
+	void message( const Message& message_ )
+	{
+		assert(EnumStateMachine::state != Definition::none);
+		assert(message_.event == Event::Stop || (message_.event >= Event::User && message_.event < N));
+
+		const Message handled_{message_, EnumStateMachine::self()};
+
+		if      (handled_.event >= Event::User) EnumStateMachine::callAction(EnumStateMachine::def->resolve(EnumStateMachine::state, handled_.event, handled_), handled_);
+		else if (handled_.event == Event::Stop) EnumStateMachine::transition(Definition::none, Definition::none, {Message{}, EnumStateMachine::self()});
+	}
+
+/******************************************************************************
+ * Name              : hsm::EnumStateMachine::transition
+ * Description       : set the transition target state from the event handler
+ * Parameters        :
+ *            target : transition target state
+ * Return            : none
+ ******************************************************************************/
+
+	void transition( State& target_ )
+	{
+		EnumStateMachine::target = EnumStateMachine::getState(&target_);
+	}
+
+/******************************************************************************
+ * Name              : hsm::EnumStateMachine::from
+ * Description       : get the hsm object handling the message; use it in event handler
+ * Parameters        :
+ *               msg : message passed to the event handler
+ * Return            : reference to the hsm object
+ ******************************************************************************/
+
+	static EnumStateMachine& from( const Message& message_ )
+	{
+		assert(message_.hsm != nullptr);
+
+		return *reinterpret_cast<EnumStateMachine *>(message_.hsm);
+	}
+
+/* -------------------------------------------------------------------------- */
+
+	private:
+	const Definition *def;               // hsm definition
+	unsigned state{Definition::none};    // index of the current hsm state
+	unsigned target{Definition::none};   // index of the transition target set by the user
+	                                     // in event handler procedure with the function 'transition'
+
+/******************************************************************************
+ * Name              : hsm::EnumStateMachine::self
+ * Description       : get the value of the 'hsm' field of the message passed to the event handler
+ * Parameters        : none
+ * Return            : pointer to the hsm object, converted back with the function 'from'
+ * Note              : for internal use
+ ******************************************************************************/
+
+	StateMachine *self()
+	{
+		return reinterpret_cast<StateMachine *>(this);
+	}
+
+/******************************************************************************
+ * Name              : hsm::EnumStateMachine::getState
+ * Description       : get index of the given hsm state
+ * Parameters        :
+ *             state : pointer to hsm state
+ * Return            : hsm state index
+ * Note              : for internal use
+ ******************************************************************************/
+
+	unsigned getState( const State *state_ ) const
+	{
+		unsigned index_ = EnumStateMachine::def->find(state_);
+		assert(index_ != Definition::none); // all states reached by the hsm must be used by the action table
+		return index_;
+	}
+
+/******************************************************************************
+ * Name              : hsm::EnumStateMachine::callAction
+ * Description       : handle the message by the given hsm action
+ * Parameters        :
+ *            action : index of action handling the event
+ *           message : received message
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void callAction( unsigned action_, const Message& message_ )
+	{
+		if (action_ == Definition::none)
+			return;
+
+		const typename Definition::Link& link_ = EnumStateMachine::def->links[action_];
+
+		EnumStateMachine::target = link_.owner;
+
+		unsigned target_ = EnumStateMachine::def->callHandler(action_, message_) ? EnumStateMachine::target : link_.target;
+
+		if (target_ == link_.owner)
+			return;
+
+		assert(message_.event >= Event::User || EnumStateMachine::def->getPrev(target_) == link_.owner);
+
+		EnumStateMachine::transition(target_, EnumStateMachine::def->getRoot(EnumStateMachine::state, target_), message_);
+	}
+
+/******************************************************************************
+ * Name              : hsm::EnumStateMachine::callHandler
+ * Description       : invoke event handler assigned to the given state and system event
+ * Parameters        :
+ *             state : index of state receiving the message
+ *           message : received message
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void callHandler( unsigned state_, const Message& message_ )
+	{
+		unsigned action_ = EnumStateMachine::def->lut[state_][message_.event];
+
+		if (action_ != Definition::none)
+			EnumStateMachine::def->callHandler(action_, message_);
+	}
+
+/******************************************************************************
+ * Name              : hsm::EnumStateMachine::transition
+ * Description       : do the transition to the given target state through the given root state
+ * Parameters        :
+ *              next : index of transition target state
+ *              root : index of common ancestor of the current and the target state
+ *           message : handled message
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void transition( unsigned next_, unsigned root_, const Message& message_ )
+	{
+		const Message exit_{message_, Event::Exit};
+		while (EnumStateMachine::state != root_)
+		{
+			EnumStateMachine::callHandler(EnumStateMachine::state, exit_);
+			EnumStateMachine::state = EnumStateMachine::def->getPrev(EnumStateMachine::state);
+		}
+
+		const Message entry_{message_, Event::Entry};
+		while (EnumStateMachine::state != next_)
+		{
+			EnumStateMachine::state = EnumStateMachine::def->getNext(EnumStateMachine::state, next_);
+			EnumStateMachine::callHandler(EnumStateMachine::state, entry_);
+		}
+
+		if (EnumStateMachine::state != Definition::none)
+		{
+			const Message init_{message_, Event::Init};
+			EnumStateMachine::callAction(EnumStateMachine::def->resolve(EnumStateMachine::state, Event::Init, init_), init_);
+		}
+	}
+};
+
+/* -------------------------------------------------------------------------- */
+
+}     //  namespace hsm
+
+#endif//__HSMENUM_HPP
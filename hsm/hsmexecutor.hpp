@@ -0,0 +1,360 @@
+/******************************************************************************
+
+    @file    hsmexecutor.hpp
+    @author  Rajmund Szymanski
+    @date    14.10.2026
+    @brief   This file contains definitions of work-stealing executor for hsm.
+
+ ******************************************************************************
+
+   Copyright (c) 2018-2026 Rajmund Szymanski. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+
+ ******************************************************************************/
+
+#ifndef __HSMEXECUTOR_HPP
+#define __HSMEXECUTOR_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cassert>
+#include <cstddef>
+#include "hsminbox.hpp"
+
+namespace hsm {
+
+struct Executor;
+
+/******************************************************************************
+ *
+ * Class             : Actor
+ *
+ * Description       : hsm scheduled by the executor when its inbox becomes signaled
+ *                     the actor handles a bounded batch of messages to completion and yields
+ *                     the actor is never run by two workers at the same time and thus
+ *                     the hsm handles all its messages sequentially
+ *
+ * Constructor parameters
+ *          executor : executor running the actor
+ *             inbox : inbox of the hsm (BoundedInbox or UnboundedInbox)
+ *
+ * Note              : the actor takes over the notification function of the inbox
+ *                     the actor must not be destroyed while its inbox can still be posted
+ *                     or while it is scheduled
+ *
+ ******************************************************************************/
+
+struct Actor
+{
+	template<class T>
+	Actor( Executor& executor_, T& inbox_ ): executor{executor_}, inbox{&inbox_}, pump{Actor::pumpInbox<T>}
+	{
+		inbox_.notify(Actor::wakeup, this);
+	}
+
+	Actor( Actor&& ) = delete;
+	Actor( const Actor& ) = delete;
+	Actor& operator=( Actor&& ) = delete;
+	Actor& operator=( const Actor& ) = delete;
+
+/******************************************************************************
+ * Name              : hsm::Actor::schedule
+ * Description       : schedule the actor to run; can be called from any thread
+ * Parameters        : none
+ * Return            : none
+ * Note              : called by the inbox notification function
+ ******************************************************************************/
+
+	void schedule();
+
+/* -------------------------------------------------------------------------- */
+
+	private:
+	enum Status: unsigned { Idle, Scheduled, Running, Rescheduled };
+
+	Executor& executor;                    // executor running the actor
+	void *inbox;                           // inbox of the hsm
+	bool (*pump)( void *, std::size_t );   // function handling a batch of messages from the inbox
+	std::atomic<unsigned> status{Idle};    // scheduling status of the actor
+
+	template<class T>
+	static bool pumpInbox( void *inbox_, std::size_t limit_ ) { return static_cast<T *>(inbox_)->pump(limit_); }
+	static void wakeup( void *actor_ ) { static_cast<Actor *>(actor_)->schedule(); }
+
+	void run( std::size_t );
+
+	friend struct Executor;
+};
+
+/******************************************************************************
+ *
+ * Class             : Executor
+ *
+ * Description       : work-stealing executor running actors on a fixed pool of worker threads
+ *                     each worker has its own queue of scheduled actors;
+ *                     the worker runs the most recently scheduled actor first
+ *                     and an idle worker steals the oldest actor from other workers
+ *
+ * Constructor parameters
+ *           workers : number of worker threads (default: number of hardware threads)
+ *             batch : maximum number of messages handled by the actor at once
+ *
+ * Note              : the destructor waits for the workers to run all scheduled actors
+ *
+ ******************************************************************************/
+
+struct Executor
+{
+	Executor( std::size_t workers_ = 0, std::size_t batch_ = 64 ): batch{batch_}, workers(workers_ ? workers_ : Executor::concurrency())
+	{
+		assert(batch_ > 0);
+
+		for (Worker& worker_: Executor::workers)
+			worker_.thread = std::thread(&Executor::loop, this, &worker_);
+	}
+
+   ~Executor()
+	{
+		{
+			std::lock_guard<std::mutex> lock_(Executor::mutex);
+			Executor::stopped = true;
+		}
+		Executor::condition.notify_all();
+
+		for (Worker& worker_: Executor::workers)
+			worker_.thread.join();
+	}
+
+	Executor( Executor&& ) = delete;
+	Executor( const Executor& ) = delete;
+	Executor& operator=( Executor&& ) = delete;
+	Executor& operator=( const Executor& ) = delete;
+
+/******************************************************************************
+ * Name              : hsm::Executor::size
+ * Description       : get the number of worker threads
+ * Parameters        : none
+ * Return            : number of worker threads
+ ******************************************************************************/
+
+	std::size_t size() const
+	{
+		return Executor::workers.size();
+	}
+
+/* -------------------------------------------------------------------------- */
+
+	private:
+	struct Worker
+	{
+		std::mutex mutex;                   // protects the queue
+		std::deque<Actor *> queue;          // actors scheduled on the worker
+		std::thread thread;                 // worker thread
+	};
+
+	const std::size_t batch;               // maximum number of messages handled by the actor at once
+	std::vector<Worker> workers;           // pool of workers
+	std::atomic<std::size_t> pending{};    // number of scheduled actors
+	std::atomic<std::size_t> sleeping{};   // number of waiting workers
+	std::atomic<std::size_t> next{};       // round-robin counter for actors scheduled from outside the pool
+	std::mutex mutex;                      // protects the waiting of workers
+	std::condition_variable condition;     // wakes up waiting workers
+	bool stopped{};                        // the executor is being destroyed
+
+	static inline thread_local Worker *current{}; // worker of the calling thread
+
+	static std::size_t concurrency()
+	{
+		std::size_t count_ = std::thread::hardware_concurrency();
+		return count_ ? count_ : 1;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Executor::push
+ * Description       : put the actor in the queue of the calling worker
+ *                     or in the next worker queue if called from outside the pool
+ * Parameters        :
+ *             actor : scheduled actor
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void push( Actor *actor_ )
+	{
+		Worker *worker_ = Executor::current;
+
+		if (worker_ == nullptr || worker_ < Executor::workers.data() || worker_ >= Executor::workers.data() + Executor::workers.size())
+			worker_ = &Executor::workers[Executor::next.fetch_add(1, std::memory_order_relaxed) % Executor::workers.size()];
+
+		{
+			std::lock_guard<std::mutex> lock_(worker_->mutex);
+			worker_->queue.push_back(actor_);
+		}
+
+		Executor::pending.fetch_add(1, std::memory_order_seq_cst);
+		if (Executor::sleeping.load(std::memory_order_seq_cst) > 0)
+		{
+			std::lock_guard<std::mutex> lock_(Executor::mutex);
+			Executor::condition.notify_one();
+		}
+	}
+
+/******************************************************************************
+ * Name              : hsm::Executor::pop
+ * Description       : get the most recently scheduled actor from the worker queue
+ *                     or steal the oldest actor from another worker queue
+ * Parameters        :
+ *            worker : calling worker
+ * Return            : pointer to the actor or nullptr if there is no scheduled actor
+ * Note              : for internal use
+ ******************************************************************************/
+
+	Actor* pop( Worker *worker_ )
+	{
+		Actor *actor_ = nullptr;
+
+		{
+			std::lock_guard<std::mutex> lock_(worker_->mutex);
+			if (!worker_->queue.empty())
+			{
+				actor_ = worker_->queue.back();
+				worker_->queue.pop_back();
+			}
+		}
+
+		std::size_t count_ = Executor::workers.size();
+		std::size_t index_ = static_cast<std::size_t>(worker_ - Executor::workers.data());
+
+		for (std::size_t i = 1; actor_ == nullptr && i < count_; i++)
+		{
+			Worker& victim_ = Executor::workers[(index_ + i) % count_];
+			std::lock_guard<std::mutex> lock_(victim_.mutex);
+			if (!victim_.queue.empty())
+			{
+				actor_ = victim_.queue.front();
+				victim_.queue.pop_front();
+			}
+		}
+
+		if (actor_ != nullptr)
+			Executor::pending.fetch_sub(1, std::memory_order_relaxed);
+
+		return actor_;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Executor::loop
+ * Description       : worker thread function
+ * Parameters        :
+ *            worker : worker running the function
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void loop( Worker *worker_ )
+	{
+		Executor::current = worker_;
+
+		for (;;)
+		{
+			Actor *actor_ = Executor::pop(worker_);
+			if (actor_ != nullptr)
+			{
+				actor_->run(Executor::batch);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock_(Executor::mutex);
+			Executor::sleeping.fetch_add(1, std::memory_order_seq_cst);
+			Executor::condition.wait(lock_, [this]{ return Executor::stopped || Executor::pending.load(std::memory_order_seq_cst) > 0; });
+			Executor::sleeping.fetch_sub(1, std::memory_order_relaxed);
+			if (Executor::stopped && Executor::pending.load(std::memory_order_seq_cst) == 0)
+				break;
+		}
+
+		Executor::current = nullptr;
+	}
+
+	friend struct Actor;
+};
+
+/******************************************************************************
+ * Name              : hsm::Actor::schedule
+ ******************************************************************************/
+
+inline void Actor::schedule()
+{
+	unsigned status_ = Actor::status.load(std::memory_order_acquire);
+
+	for (;;)
+	{
+		if (status_ == Actor::Idle)
+		{
+			if (Actor::status.compare_exchange_weak(status_, Actor::Scheduled, std::memory_order_acq_rel))
+			{
+				Actor::executor.push(this);
+				return;
+			}
+		}
+		else
+		if (status_ == Actor::Running)
+		{
+			if (Actor::status.compare_exchange_weak(status_, Actor::Rescheduled, std::memory_order_acq_rel))
+				return;
+		}
+		else
+		{
+			return; // already scheduled
+		}
+	}
+}
+
+/******************************************************************************
+ * Name              : hsm::Actor::run
+ * Description       : handle a batch of messages from the inbox and reschedule the actor if needed
+ * Parameters        :
+ *             limit : maximum number of messages to handle
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+inline void Actor::run( std::size_t limit_ )
+{
+	Actor::status.store(Actor::Running, std::memory_order_seq_cst);
+
+	bool more_ = Actor::pump(Actor::inbox, limit_);
+
+	unsigned status_ = Actor::Running;
+	if (more_ || !Actor::status.compare_exchange_strong(status_, Actor::Idle, std::memory_order_acq_rel))
+	{
+		Actor::status.store(Actor::Scheduled, std::memory_order_release);
+		Actor::executor.push(this);
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+
+}     //  namespace hsm
+
+#endif//__HSMEXECUTOR_HPP
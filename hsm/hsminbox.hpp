@@ -0,0 +1,505 @@
+/******************************************************************************
+
+    @file    hsminbox.hpp
+    @author  Rajmund Szymanski
+    @date    14.10.2026
+    @brief   This file contains definitions of lock-free message inboxes for hsm.
+
+ ******************************************************************************
+
+   Copyright (c) 2018-2026 Rajmund Szymanski. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+
+ ******************************************************************************/
+
+#ifndef __HSMINBOX_HPP
+#define __HSMINBOX_HPP
+
+#include <atomic>
+#include <limits>
+#include <cassert>
+#include <cstddef>
+#include "hsm.hpp"
+
+namespace hsm {
+
+/******************************************************************************
+ *
+ * Class             : Inbox
+ *
+ * Description       : base of the lock-free multi-producer / single-consumer message inbox
+ *                     messages are posted from any thread and handled by the hsm
+ *                     on the owner thread with the function 'pump'
+ *                     the notification function is called only by the producer
+ *                     that finds the inbox not signaled, i.e. once per 'pump'
+ *                     messages are left in the inbox while the handling of the hsm is suspended;
+ *                     call 'pump' again after the hsm resumes
+ *
+ * Constructor parameters
+ *               hsm : hsm handling the messages posted to the inbox
+ *
+ ******************************************************************************/
+
+struct Inbox
+{
+	Inbox( StateMachine& hsm_ ): hsm{hsm_} {}
+
+	Inbox( Inbox&& ) = delete;
+	Inbox( const Inbox& ) = delete;
+	Inbox& operator=( Inbox&& ) = delete;
+	Inbox& operator=( const Inbox& ) = delete;
+
+/******************************************************************************
+ * Name              : hsm::Inbox::notify
+ * Description       : set the function called when the inbox becomes signaled
+ *                     (e.g. to wake up or to schedule the owner thread)
+ *                     set the notification function before posting any message
+ * Parameters        :
+ *          function : notification function
+ *           context : context pointer passed to the notification function
+ * Return            : none
+ ******************************************************************************/
+
+	void notify( void (*function_)( void * ), void *context_ )
+	{
+		Inbox::function = function_;
+		Inbox::context = context_;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Inbox::dropped
+ * Description       : get number of messages pumped from the inbox and dropped by the hsm
+ *                     (the message queue of the hsm was full); call from the owner thread only
+ * Parameters        : none
+ * Return            : number of dropped messages
+ ******************************************************************************/
+
+	std::size_t dropped() const
+	{
+		return Inbox::drops;
+	}
+
+/* -------------------------------------------------------------------------- */
+
+	protected:
+	StateMachine& hsm;                     // hsm handling the messages
+	void (*function)( void * ){};          // notification function
+	void *context{};                       // notification function context
+	std::size_t drops{};                   // number of messages dropped by the hsm
+	alignas(64) std::atomic<bool> signal{};// the inbox has been signaled
+
+/******************************************************************************
+ * Name              : hsm::Inbox::wakeup
+ * Description       : signal the inbox and call the notification function if not signaled yet
+ * Parameters        : none
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void wakeup()
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst); // pairs with the fence in 'clear'
+
+		if (!Inbox::signal.load(std::memory_order_relaxed) && !Inbox::signal.exchange(true, std::memory_order_acq_rel))
+			if (Inbox::function != nullptr)
+				Inbox::function(Inbox::context);
+	}
+
+/******************************************************************************
+ * Name              : hsm::Inbox::clear
+ * Description       : clear the inbox signal before the inbox is drained
+ * Parameters        : none
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void clear()
+	{
+		Inbox::signal.store(false, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst); // pairs with the fence in 'wakeup'
+	}
+
+/******************************************************************************
+ * Name              : hsm::Inbox::suspended
+ * Description       : check if the handling of the hsm is suspended
+ * Parameters        : none
+ * Return            : true if the hsm would queue the message instead of handling it
+ * Note              : for internal use
+ ******************************************************************************/
+
+	bool suspended() const
+	{
+		return Inbox::hsm.isSuspended();
+	}
+
+/******************************************************************************
+ * Name              : hsm::Inbox::deliver
+ * Description       : pass the message to the hsm and count the dropped message
+ * Parameters        :
+ *               msg : message
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void deliver( const Message& message_ )
+	{
+		if (!Inbox::hsm.message(message_))
+			Inbox::drops++;
+	}
+};
+
+/******************************************************************************
+ *
+ * Class             : BoundedInbox
+ *
+ * Description       : bounded lock-free multi-producer / single-consumer message inbox
+ *                     ring buffer of messages with static storage, never allocates
+ *
+ * Template parameters
+ *                 N : capacity of the inbox (power of two)
+ *
+ * Constructor parameters
+ *               hsm : hsm handling the messages posted to the inbox
+ *
+ ******************************************************************************/
+
+template<std::size_t N>
+struct BoundedInbox : Inbox
+{
+	static_assert(N > 0 && (N & (N - 1)) == 0, "capacity of the inbox must be a power of two");
+
+	BoundedInbox( StateMachine& hsm_ ): Inbox{hsm_}
+	{
+		for (std::size_t index_ = 0; index_ < N; index_++)
+			BoundedInbox::cells[index_].sequence.store(index_, std::memory_order_relaxed);
+	}
+
+/******************************************************************************
+ * Name              : hsm::BoundedInbox::post
+ * Description       : put user message to the inbox; can be called from any thread
+ * Parameters        :
+ *               msg : message
+ * Return            : false if the inbox is full
+ ******************************************************************************/
+
+	bool post( const Message& message_ )
+	{
+		std::size_t position_ = BoundedInbox::tail.load(std::memory_order_relaxed);
+		Cell *cell_;
+
+		for (;;)
+		{
+			cell_ = &BoundedInbox::cells[position_ & (N - 1)];
+			std::size_t sequence_ = cell_->sequence.load(std::memory_order_acquire);
+
+			auto diff_ = static_cast<std::ptrdiff_t>(sequence_ - position_);
+
+			if (diff_ == 0)
+			{
+				if (BoundedInbox::tail.compare_exchange_weak(position_, position_ + 1, std::memory_order_relaxed))
+					break;
+			}
+			else
+			if (diff_ < 0)
+			{
+				return false;
+			}
+			else
+			{
+				position_ = BoundedInbox::tail.load(std::memory_order_relaxed);
+			}
+		}
+
+		cell_->message = message_;
+		cell_->sequence.store(position_ + 1, std::memory_order_release);
+
+		Inbox::wakeup();
+		return true;
+	}
+
+/******************************************************************************
+ * Name              : hsm::BoundedInbox::pump
+ * Description       : handle messages posted to the inbox; call from the owner thread only
+ *                     stops when the handling of the hsm is suspended
+ * Parameters        :
+ *             limit : maximum number of messages to handle
+ * Return            : true if the inbox may still contain messages
+ ******************************************************************************/
+
+	bool pump( std::size_t limit_ = std::numeric_limits<std::size_t>::max() )
+	{
+		Message message_;
+
+		Inbox::clear();
+
+		while (limit_ > 0 && !Inbox::suspended() && BoundedInbox::pop(message_))
+		{
+			Inbox::deliver(message_);
+			limit_--;
+		}
+
+		return (limit_ == 0 || Inbox::suspended()) && !BoundedInbox::empty();
+	}
+
+/******************************************************************************
+ * Name              : hsm::BoundedInbox::empty
+ * Description       : check if the inbox is empty; call from the owner thread only
+ * Parameters        : none
+ * Return            : true if there is no published message in the inbox
+ ******************************************************************************/
+
+	bool empty() const
+	{
+		const Cell& cell_ = BoundedInbox::cells[BoundedInbox::head & (N - 1)];
+
+		return cell_.sequence.load(std::memory_order_acquire) != BoundedInbox::head + 1;
+	}
+
+/* -------------------------------------------------------------------------- */
+
+	private:
+	struct Cell
+	{
+		std::atomic<std::size_t> sequence; // cell sequence number
+		Message message;                   // posted message
+	};
+
+	Cell cells[N];                          // storage of messages
+	alignas(64) std::atomic<std::size_t> tail{}; // producers position
+	alignas(64) std::size_t head{};         // consumer position
+
+/******************************************************************************
+ * Name              : hsm::BoundedInbox::pop
+ * Description       : get message from the inbox
+ * Parameters        :
+ *               msg : received message
+ * Return            : false if the inbox is empty
+ * Note              : for internal use
+ ******************************************************************************/
+
+	bool pop( Message& message_ )
+	{
+		Cell& cell_ = BoundedInbox::cells[BoundedInbox::head & (N - 1)];
+
+		if (cell_.sequence.load(std::memory_order_acquire) != BoundedInbox::head + 1)
+			return false;
+
+		message_ = cell_.message;
+		cell_.sequence.store(BoundedInbox::head + N, std::memory_order_release);
+		BoundedInbox::head++;
+
+		return true;
+	}
+};
+
+/******************************************************************************
+ *
+ * Class             : InboxNode
+ *
+ * Description       : node of the unbounded message inbox, provided by the producer
+ *                     the node must stay valid until the message has been handled,
+ *                     also by the suspended event handler;
+ *                     then the release function is called (if any)
+ *
+ * Constructor parameters
+ *               msg : message
+ *           release : function called after the message has been handled
+ *
+ ******************************************************************************/
+
+struct InboxNode
+{
+	InboxNode() {}
+	InboxNode( const Message& message_, void (*release_)( InboxNode * ) = nullptr ): message{message_}, release{release_} {}
+
+	Message message;                 // posted message
+	void (*release)( InboxNode * ){};// function called after the message has been handled
+
+	private:
+	std::atomic<InboxNode *> next{}; // next node in the inbox
+
+	friend struct UnboundedInbox;
+};
+
+/******************************************************************************
+ *
+ * Class             : UnboundedInbox
+ *
+ * Description       : unbounded lock-free multi-producer / single-consumer message inbox
+ *                     intrusive list of nodes provided by producers, never allocates
+ *
+ * Constructor parameters
+ *               hsm : hsm handling the messages posted to the inbox
+ *
+ ******************************************************************************/
+
+struct UnboundedInbox : Inbox
+{
+	UnboundedInbox( StateMachine& hsm_ ): Inbox{hsm_} {}
+
+/******************************************************************************
+ * Name              : hsm::UnboundedInbox::post
+ * Description       : put the node with user message to the inbox; can be called from any thread
+ * Parameters        :
+ *              node : inbox node with user message
+ * Return            : none
+ ******************************************************************************/
+
+	void post( InboxNode& node_ )
+	{
+		UnboundedInbox::push(&node_);
+		Inbox::wakeup();
+	}
+
+/******************************************************************************
+ * Name              : hsm::UnboundedInbox::pump
+ * Description       : handle messages posted to the inbox; call from the owner thread only
+ *                     stops when the handling of the hsm is suspended; the node of the message
+ *                     which suspended the handling is released by the first 'pump' after the hsm resumes
+ * Parameters        :
+ *             limit : maximum number of messages to handle
+ * Return            : true if the inbox may still contain messages
+ ******************************************************************************/
+
+	bool pump( std::size_t limit_ = std::numeric_limits<std::size_t>::max() )
+	{
+		InboxNode *node_;
+
+		Inbox::clear();
+
+		if (UnboundedInbox::pending != nullptr)
+		{
+			if (Inbox::suspended())
+				return !UnboundedInbox::empty();
+
+			UnboundedInbox::release(UnboundedInbox::pending);
+			UnboundedInbox::pending = nullptr;
+		}
+
+		while (limit_ > 0 && (node_ = UnboundedInbox::pop()) != nullptr)
+		{
+			Inbox::deliver(node_->message);
+			limit_--;
+
+			if (Inbox::suspended())
+			{
+				UnboundedInbox::pending = node_;
+				return !UnboundedInbox::empty();
+			}
+
+			UnboundedInbox::release(node_);
+		}
+
+		return limit_ == 0 && !UnboundedInbox::empty();
+	}
+
+/******************************************************************************
+ * Name              : hsm::UnboundedInbox::empty
+ * Description       : check if the inbox is empty; call from the owner thread only
+ * Parameters        : none
+ * Return            : true if there is no message in the inbox
+ ******************************************************************************/
+
+	bool empty() const
+	{
+		return UnboundedInbox::head == &(UnboundedInbox::stub) && UnboundedInbox::stub.next.load(std::memory_order_acquire) == nullptr;
+	}
+
+/* -------------------------------------------------------------------------- */
+
+	private:
+	InboxNode stub;                                        // internal node of the inbox
+	InboxNode *pending{};                                  // node of the message handled by the suspended hsm
+	alignas(64) std::atomic<InboxNode *> tail{&(UnboundedInbox::stub)}; // the last node, producers position
+	alignas(64) InboxNode *head{&(UnboundedInbox::stub)};    // the first node, consumer position
+
+/******************************************************************************
+ * Name              : hsm::UnboundedInbox::release
+ * Description       : call the release function of the node of the handled message
+ * Parameters        :
+ *              node : inbox node
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	static void release( InboxNode *node_ )
+	{
+		if (node_->release != nullptr)
+			node_->release(node_);
+	}
+
+/******************************************************************************
+ * Name              : hsm::UnboundedInbox::push
+ * Description       : link the node at the end of the inbox
+ * Parameters        :
+ *              node : inbox node
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void push( InboxNode *node_ )
+	{
+		node_->next.store(nullptr, std::memory_order_relaxed);
+		InboxNode *prev_ = UnboundedInbox::tail.exchange(node_, std::memory_order_acq_rel);
+		prev_->next.store(node_, std::memory_order_release);
+	}
+
+/******************************************************************************
+ * Name              : hsm::UnboundedInbox::pop
+ * Description       : unlink the first node from the inbox
+ * Parameters        : none
+ * Return            : pointer to the unlinked node or nullptr if no node is ready
+ * Note              : for internal use
+ ******************************************************************************/
+
+	InboxNode* pop()
+	{
+		InboxNode *head_ = UnboundedInbox::head;
+		InboxNode *next_ = head_->next.load(std::memory_order_acquire);
+
+		if (head_ == &(UnboundedInbox::stub))
+		{
+			if (next_ == nullptr)
+				return nullptr;
+			UnboundedInbox::head = head_ = next_;
+			next_ = next_->next.load(std::memory_order_acquire);
+		}
+
+		if (next_ == nullptr)
+		{
+			if (head_ != UnboundedInbox::tail.load(std::memory_order_acquire))
+				return nullptr; // the producer has not finished linking the node
+
+			UnboundedInbox::push(&(UnboundedInbox::stub));
+			next_ = head_->next.load(std::memory_order_acquire);
+			if (next_ == nullptr)
+				return nullptr;
+		}
+
+		UnboundedInbox::head = next_;
+		return head_;
+	}
+};
+
+/* -------------------------------------------------------------------------- */
+
+}     //  namespace hsm
+
+#endif//__HSMINBOX_HPP
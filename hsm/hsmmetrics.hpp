@@ -0,0 +1,348 @@
+/******************************************************************************
+
+    @file    hsmmetrics.hpp
+    @author  Rajmund Szymanski
+    @date    14.10.2026
+    @brief   This file contains definitions of performance counters for hsm.
+
+ ******************************************************************************
+
+   Copyright (c) 2018-2026 Rajmund Szymanski. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+
+ ******************************************************************************/
+
+#ifndef __HSMMETRICS_HPP
+#define __HSMMETRICS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include "hsmconfig.hpp"
+
+#ifndef HSM_METRICS_CLOCK
+#define HSM_METRICS_CLOCK() static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count())
+#endif
+
+namespace hsm {
+
+struct State; // forward declaration
+
+/******************************************************************************
+ *
+ * Class             : Metrics
+ *
+ * Description       : aggregate performance counters of hsm instances
+ *                     can be attached to any number of hsm instances sharing the hsm definition
+ *                     counters are sharded per thread, each shard is cache-line aligned,
+ *                     and can be read with the function 'snapshot' without stopping the hsm
+ *                     time is measured with HSM_METRICS_CLOCK() in nanoseconds
+ *                     (std::chrono::steady_clock by default)
+ *
+ * Constructor parameters
+ *            shards : number of counter shards (default: number of hardware threads)
+ *
+ ******************************************************************************/
+
+struct Metrics
+{
+	static constexpr std::size_t buckets = 16; // latency histogram buckets: [0..1], [2..3], [4..7] ... ns
+
+	struct StateCounters
+	{
+		const State *state{};              // hsm state
+		std::uint64_t entries{};           // number of entries to the state
+		std::uint64_t exits{};             // number of exits from the state
+		std::uint64_t time{};              // total time spent in the state (ns)
+		std::uint64_t entry[buckets]{};    // latency histogram of the entry event handler
+		std::uint64_t exit[buckets]{};     // latency histogram of the exit event handler
+	};
+
+	struct EventCounters
+	{
+		std::uint64_t hits{};              // number of events handled in the state (or its ancestor)
+		std::uint64_t walked{};            // total number of ancestors walked before the handling state
+		std::uint64_t unhandled{};         // number of events not handled in the state
+	};
+
+	struct Snapshot
+	{
+		std::vector<unsigned> events;      // event values of the columns; the last column (0) counts all other events
+		std::vector<StateCounters> states; // counters of states, in the order of the hsm definition
+		std::vector<EventCounters> cells;  // counters of events received in the state: states x columns
+
+/******************************************************************************
+ * Name              : hsm::Metrics::Snapshot::find
+ * Description       : find counters of the given state
+ * Parameters        :
+ *             state : hsm state
+ * Return            : pointer to the state counters or nullptr if the state is not used by the hsm
+ ******************************************************************************/
+
+		const StateCounters* find( const State& state_ ) const
+		{
+			for (auto& counters_: Snapshot::states)
+				if (counters_.state == &state_)
+					return &counters_;
+
+			return nullptr;
+		}
+
+/******************************************************************************
+ * Name              : hsm::Metrics::Snapshot::find
+ * Description       : find counters of the given event received in the given state
+ * Parameters        :
+ *             state : hsm state
+ *             event : event value
+ * Return            : pointer to the event counters or nullptr if the state is not used by the hsm
+ ******************************************************************************/
+
+		const EventCounters* find( const State& state_, unsigned event_ ) const
+		{
+			const StateCounters *counters_ = Snapshot::find(state_);
+			if (counters_ == nullptr)
+				return nullptr;
+
+			std::size_t column_ = 0;
+			while (column_ + 1 < Snapshot::events.size() && Snapshot::events[column_] != event_)
+				column_++;
+
+			return &Snapshot::cells[static_cast<std::size_t>(counters_ - Snapshot::states.data()) * Snapshot::events.size() + column_];
+		}
+	};
+
+	Metrics( std::size_t shards_ = 0 ): shards{shards_ ? shards_ : Metrics::concurrency()} {}
+
+	Metrics( Metrics&& ) = delete;
+	Metrics( const Metrics& ) = delete;
+	Metrics& operator=( Metrics&& ) = delete;
+	Metrics& operator=( const Metrics& ) = delete;
+
+/******************************************************************************
+ * Name              : hsm::Metrics::snapshot
+ * Description       : sum the counters of all shards
+ *                     can be called from any thread while the hsm is running
+ * Parameters        :
+ *            states : states of the hsm definition
+ *            number : number of states
+ *            events : event values of the dispatch table columns
+ *             count : number of dispatch table columns without the last one
+ * Return            : snapshot of the counters
+ * Note              : use the function hsm::StateMachine::snapshot
+ ******************************************************************************/
+
+	Snapshot snapshot( const State *const *states_, std::size_t number_, const unsigned *events_, std::size_t count_ ) const
+	{
+		Snapshot snapshot_;
+		snapshot_.events.assign(events_, events_ + count_);
+		snapshot_.events.push_back(0); // the last column: all other events
+		snapshot_.states.resize(Metrics::count);
+		snapshot_.cells.resize(Metrics::count * Metrics::width);
+
+		for (std::size_t shard_ = 0; shard_ < Metrics::shards && !Metrics::lines.empty(); shard_++)
+		{
+			const Counter *data_ = Metrics::lines[shard_ * Metrics::stride].data;
+
+			for (std::size_t state_ = 0; state_ < Metrics::count; state_++, data_ += Metrics::StateSize)
+			{
+				StateCounters& counters_ = snapshot_.states[state_];
+				counters_.entries += data_[Metrics::Entries].load(std::memory_order_relaxed);
+				counters_.exits   += data_[Metrics::Exits].load(std::memory_order_relaxed);
+				counters_.time    += data_[Metrics::Time].load(std::memory_order_relaxed);
+				for (std::size_t bucket_ = 0; bucket_ < buckets; bucket_++)
+				{
+					counters_.entry[bucket_] += data_[Metrics::Entry + bucket_].load(std::memory_order_relaxed);
+					counters_.exit[bucket_]  += data_[Metrics::Exit + bucket_].load(std::memory_order_relaxed);
+				}
+			}
+
+			for (auto& counters_: snapshot_.cells)
+			{
+				counters_.hits      += data_[Metrics::Hits].load(std::memory_order_relaxed);
+				counters_.walked    += data_[Metrics::Walked].load(std::memory_order_relaxed);
+				counters_.unhandled += data_[Metrics::Unhandled].load(std::memory_order_relaxed);
+				data_ += Metrics::CellSize;
+			}
+		}
+
+		const std::uint64_t now_ = HSM_METRICS_CLOCK();
+		for (std::size_t state_ = 0; state_ < Metrics::count; state_++)
+		{
+			StateCounters& counters_ = snapshot_.states[state_];
+			counters_.state = state_ < number_ ? states_[state_] : nullptr;
+			// the active state has been entered once more than exited; its entry time is counted as negative
+			counters_.time += (counters_.entries - counters_.exits) * now_;
+		}
+
+		return snapshot_;
+	}
+
+/* -------------------------------------------------------------------------- */
+
+	private:
+	using Counter = std::atomic<std::uint64_t>;
+
+	enum: std::size_t { Entries, Exits, Time, Entry, Exit = Entry + buckets, StateSize = Exit + buckets };
+	enum: std::size_t { Hits, Walked, Unhandled, CellSize };
+
+	struct alignas(64) Line
+	{
+		Counter data[64 / sizeof(Counter)];
+	};
+
+	const std::size_t shards;              // number of counter shards
+	std::size_t count{};                   // number of states
+	std::size_t width{};                   // number of dispatch table columns
+	std::size_t stride{};                  // number of cache lines of the shard
+	std::vector<Line> lines;               // storage of all shards
+
+	static std::size_t concurrency()
+	{
+		std::size_t count_ = std::thread::hardware_concurrency();
+		return count_ ? count_ : 1;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Metrics::resize
+ * Description       : allocate counters for the given size of the hsm definition
+ *                     counters are cleared if the size has been changed
+ * Parameters        :
+ *             count : number of states
+ *             width : number of dispatch table columns
+ * Return            : none
+ * Note              : for internal use; must not be called while any attached hsm is running
+ ******************************************************************************/
+
+	void resize( std::size_t count_, std::size_t width_ )
+	{
+		if (Metrics::count == count_ && Metrics::width == width_ && !Metrics::lines.empty())
+			return;
+
+		constexpr std::size_t size_ = sizeof(Line::data) / sizeof(*Line::data);
+
+		Metrics::count  = count_;
+		Metrics::width  = width_;
+		Metrics::stride = (count_ * StateSize + count_ * width_ * CellSize + size_ - 1) / size_;
+		Metrics::lines  = std::vector<Line>(Metrics::shards * Metrics::stride);
+	}
+
+/******************************************************************************
+ * Name              : hsm::Metrics::shard
+ * Description       : get the counters of the shard of the calling thread
+ * Parameters        : none
+ * Return            : pointer to the counters of the shard
+ * Note              : for internal use
+ ******************************************************************************/
+
+	Counter* shard()
+	{
+		static std::atomic<std::size_t> threads_{};
+		static thread_local std::size_t thread_ = threads_.fetch_add(1, std::memory_order_relaxed);
+
+		return Metrics::lines[(thread_ % Metrics::shards) * Metrics::stride].data;
+	}
+
+	static std::size_t bucket( std::uint64_t latency_ )
+	{
+		std::size_t bucket_ = 0;
+		while ((latency_ >>= 1) != 0 && bucket_ < buckets - 1)
+			bucket_++;
+
+		return bucket_;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Metrics::entry
+ * Description       : count the entry to the state
+ * Parameters        :
+ *             state : index of the state
+ *              time : time of the entry
+ *           latency : duration of the entry event handler
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void entry( unsigned state_, std::uint64_t time_, std::uint64_t latency_ )
+	{
+		Counter *data_ = Metrics::shard() + state_ * StateSize;
+
+		data_[Entries].fetch_add(1, std::memory_order_relaxed);
+		data_[Time].fetch_sub(time_, std::memory_order_relaxed);
+		data_[Entry + Metrics::bucket(latency_)].fetch_add(1, std::memory_order_relaxed);
+	}
+
+/******************************************************************************
+ * Name              : hsm::Metrics::exit
+ * Description       : count the exit from the state
+ * Parameters        :
+ *             state : index of the state
+ *              time : time of the exit
+ *           latency : duration of the exit event handler
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void exit( unsigned state_, std::uint64_t time_, std::uint64_t latency_ )
+	{
+		Counter *data_ = Metrics::shard() + state_ * StateSize;
+
+		data_[Exits].fetch_add(1, std::memory_order_relaxed);
+		data_[Time].fetch_add(time_, std::memory_order_relaxed);
+		data_[Exit + Metrics::bucket(latency_)].fetch_add(1, std::memory_order_relaxed);
+	}
+
+/******************************************************************************
+ * Name              : hsm::Metrics::event
+ * Description       : count the event received in the state
+ * Parameters        :
+ *             state : index of the state receiving the event
+ *            column : dispatch table column of the event
+ *            walked : number of ancestors walked before the handling state
+ *                     or 'none' if the event has not been handled
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void event( unsigned state_, unsigned column_, unsigned walked_ )
+	{
+		Counter *data_ = Metrics::shard() + Metrics::count * StateSize + (state_ * Metrics::width + column_) * CellSize;
+
+		if (walked_ == ~0U)
+		{
+			data_[Unhandled].fetch_add(1, std::memory_order_relaxed);
+		}
+		else
+		{
+			data_[Hits].fetch_add(1, std::memory_order_relaxed);
+			data_[Walked].fetch_add(walked_, std::memory_order_relaxed);
+		}
+	}
+
+	friend struct StateMachine;
+};
+
+/* -------------------------------------------------------------------------- */
+
+}     //  namespace hsm
+
+#endif//__HSMMETRICS_HPP
@@ -0,0 +1,554 @@
+/******************************************************************************
+
+    @file    hsmprofile.hpp
+    @author  Rajmund Szymanski
+    @date    14.10.2026
+    @brief   This file contains definitions of the hsm profiler of recorded traces.
+
+ ******************************************************************************
+
+   Copyright (c) 2018-2026 Rajmund Szymanski. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+
+ ******************************************************************************/
+
+
+#ifndef __HSMPROFILE_HPP
+#define __HSMPROFILE_HPP
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include "hsm.hpp"
+#include "hsmtrace.hpp"
+
+namespace hsm {
+
+/******************************************************************************
+ *
+ * Class             : Profile
+ *
+ * Description       : hot-path profile of the hsm built from the recorded trace
+ *                     the graph of the state tree and actions of the definition is annotated with
+ *                     the observed frequency and latency of actions, the ancestor-walk misses
+ *                     (user events handled by the ancestor of the current state or not handled at all)
+ *                     and the transition paths; the hottest ones are highlighted
+ *                     the latency of the action is the time from its trace record to the record
+ *                     of the next event dispatched by the same hsm instance (or the last record of the trace),
+ *                     i.e. the service time of the action when the event queue of the hsm is not empty
+ *                     entries and exits are counted for states with entry and exit event handlers;
+ *                     orthogonal regions are tracked as a single current state
+ *                     the profile is written as DOT graph or JSON
+ *
+ * Constructor parameters
+ *               def : hsm definition run by the traced hsm instances (e.g. inspected binary image)
+ *             scale : duration of the trace clock tick in nanoseconds (default: 1)
+ *
+ ******************************************************************************/
+
+struct Profile
+{
+	static constexpr unsigned none = Definition::none;
+
+	explicit Profile( const Definition& def_, double scale_ = 1.0 ):
+		def{def_}, scale{scale_}, actions(def_.getActions()), states(def_.states.size()) {}
+
+/******************************************************************************
+ * Name              : hsm::Profile::add
+ * Description       : add the trace records to the profile
+ *                     records of each hsm instance must be ordered by time
+ * Parameters        :
+ *               tab : array of trace records
+ *             count : number of trace records
+ * Return            : none
+ ******************************************************************************/
+
+	void add( const TraceRecord *tab_, std::size_t count_ )
+	{
+		std::unordered_map<std::uint64_t, Machine> machines_;
+
+		for (std::size_t item_ = 0; item_ < count_; item_++)
+		{
+			const TraceRecord& record_ = tab_[item_];
+			Machine& machine_ = machines_[record_.machine];
+
+			switch (static_cast<TraceKind>(record_.kind))
+			{
+			case TraceKind::Action:
+				Profile::close(machine_, record_.time);
+				Profile::events++;
+				if (record_.data < Profile::actions.size())
+				{
+					machine_.action = record_.data;
+					machine_.start = record_.time;
+				}
+				if (Profile::valid(machine_.state) && Profile::valid(record_.state) && machine_.state != record_.state)
+					Profile::miss(machine_.state, record_.event, record_.state);
+				break;
+			case TraceKind::Unhandled:
+				Profile::close(machine_, record_.time);
+				Profile::events++;
+				if (Profile::valid(machine_.state))
+					Profile::miss(machine_.state, record_.event, none);
+				break;
+			case TraceKind::Transition:
+				Profile::paths[{ record_.state, record_.data }]++;
+				machine_.state = record_.data;
+				break;
+			case TraceKind::Exit:
+				if (Profile::valid(record_.state))
+					Profile::states[record_.state].exits++;
+				if (record_.data < Profile::actions.size())
+					Profile::actions[record_.data].count++;
+				break;
+			case TraceKind::Entry:
+				if (Profile::valid(record_.state))
+					Profile::states[record_.state].entries++;
+				if (record_.data < Profile::actions.size())
+					Profile::actions[record_.data].count++;
+				break;
+			case TraceKind::Init:
+				if (record_.data < Profile::actions.size())
+					Profile::actions[record_.data].count++;
+				break;
+			}
+
+			machine_.last = record_.time;
+		}
+
+		for (auto& item_: machines_)
+			Profile::close(item_.second, item_.second.last);
+	}
+
+/******************************************************************************
+ * Name              : hsm::Profile::dot
+ * Description       : write the profile as DOT graph
+ *                     dotted edges: state tree; solid edges: actions (self-loops for internal actions);
+ *                     dashed blue edges: ancestor-walk misses; dashed green edges: transition paths
+ *                     not covered by direct transitions; the hottest edges are red and bold
+ * Parameters        :
+ *              file : output file
+ *               top : number of the hottest actions, misses and paths to highlight (default: 5)
+ * Return            : true if the graph has been written successfully
+ ******************************************************************************/
+
+	bool dot( std::FILE *file_, std::size_t top_ = 5 ) const
+	{
+		const std::uint64_t hot_ = Profile::threshold(top_);
+
+		std::fprintf(file_, "digraph hsm {\n\tnode [shape=box, style=rounded];\n");
+
+		for (unsigned state_ = 0; state_ < Profile::states.size(); state_++)
+		{
+			std::fprintf(file_, "\ts%u [label=\"S%u\\nentries %llu\"];\n", state_, state_,
+				static_cast<unsigned long long>(Profile::states[state_].entries));
+			unsigned parent_ = Profile::def.getPrev(state_);
+			if (parent_ != none)
+				std::fprintf(file_, "\ts%u -> s%u [style=dotted, arrowhead=none, color=gray];\n", parent_, state_);
+		}
+
+		for (unsigned action_ = 0; action_ < Profile::actions.size(); action_++)
+		{
+			const Definition::Link link_ = Profile::def.getLink(action_);
+			const Counter& counter_ = Profile::actions[action_];
+			const bool hot_action_ = counter_.count > 0 && counter_.count >= hot_;
+
+			std::fprintf(file_, "\ts%u -> s%u [label=\"", link_.owner, link_.target != none ? link_.target : link_.owner);
+			Profile::label(file_, action_);
+			std::fprintf(file_, "%s\\n%llu x %.1f ns\"%s];\n", Profile::isHandled(action_) ? " handler" : link_.target == none ? " defer" : "",
+				static_cast<unsigned long long>(counter_.count), Profile::latency(counter_),
+				hot_action_ ? ", color=red, penwidth=3" : counter_.count == 0 ? ", color=gray" : "");
+		}
+
+		for (auto& miss_: Profile::sorted(Profile::misses, top_))
+			std::fprintf(file_, "\ts%u -> %s [style=dashed, color=blue, constraint=false, label=\"miss %u\\n%llu x depth %u\"];\n",
+				miss_->first.first, miss_->second.owner != none ? ("s" + std::to_string(miss_->second.owner)).c_str() : "unhandled",
+				miss_->first.second, static_cast<unsigned long long>(miss_->second.count), Profile::depth(miss_->first.first, miss_->second.owner));
+
+		for (auto& path_: Profile::sorted(Profile::paths, top_))
+			if (Profile::valid(path_->first.first) && Profile::valid(path_->first.second) && !Profile::isDirect(path_->first.first, path_->first.second))
+				std::fprintf(file_, "\ts%u -> s%u [style=dashed, color=darkgreen, constraint=false, label=\"path\\n%llu x\"];\n",
+					path_->first.first, path_->first.second, static_cast<unsigned long long>(path_->second));
+
+		if (std::any_of(std::begin(Profile::misses), std::end(Profile::misses), []( auto& miss_ ){ return miss_.second.owner == none; }))
+			std::fprintf(file_, "\tunhandled [shape=plaintext];\n");
+
+		std::fprintf(file_, "}\n");
+
+		return std::ferror(file_) == 0;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Profile::json
+ * Description       : write the profile as JSON
+ * Parameters        :
+ *              file : output file
+ *               top : number of the hottest actions, misses and paths marked as hot (default: 5)
+ * Return            : true if the profile has been written successfully
+ ******************************************************************************/
+
+	bool json( std::FILE *file_, std::size_t top_ = 5 ) const
+	{
+		const std::uint64_t hot_ = Profile::threshold(top_);
+
+		std::fprintf(file_, "{\n  \"events\": %llu,\n  \"states\": [", static_cast<unsigned long long>(Profile::events));
+		for (unsigned state_ = 0; state_ < Profile::states.size(); state_++)
+		{
+			std::fprintf(file_, "%s\n    {\"id\": %u, \"parent\": ", state_ ? "," : "", state_);
+			Profile::index(file_, Profile::def.getPrev(state_));
+			std::fprintf(file_, ", \"level\": %u, \"entries\": %llu, \"exits\": %llu}", Profile::def.getLevel(state_),
+				static_cast<unsigned long long>(Profile::states[state_].entries), static_cast<unsigned long long>(Profile::states[state_].exits));
+		}
+
+		std::fprintf(file_, "\n  ],\n  \"actions\": [");
+		for (unsigned action_ = 0; action_ < Profile::actions.size(); action_++)
+		{
+			const Definition::Link link_ = Profile::def.getLink(action_);
+			const Counter& counter_ = Profile::actions[action_];
+
+			std::fprintf(file_, "%s\n    {\"id\": %u, \"owner\": %u, \"target\": ", action_ ? "," : "", action_, link_.owner);
+			Profile::index(file_, link_.target);
+			std::fprintf(file_, ", \"events\": [");
+			const std::vector<unsigned> events_ = Profile::getEvents(action_);
+			for (std::size_t item_ = 0; item_ < events_.size(); item_++)
+				std::fprintf(file_, "%s%u", item_ ? ", " : "", events_[item_]);
+			std::fprintf(file_, "], \"handler\": %s, \"guarded\": %s, \"count\": %llu, \"latency_ns\": %.3f, \"hot\": %s}",
+				Profile::isHandled(action_) ? "true" : "false", Profile::def.isGuarded(action_) ? "true" : "false",
+				static_cast<unsigned long long>(counter_.count), Profile::latency(counter_), counter_.count > 0 && counter_.count >= hot_ ? "true" : "false");
+		}
+
+		std::fprintf(file_, "\n  ],\n  \"misses\": [");
+		std::size_t rank_ = 0;
+		for (auto& miss_: Profile::sorted(Profile::misses, Profile::misses.size()))
+		{
+			std::fprintf(file_, "%s\n    {\"state\": %u, \"event\": %u, \"owner\": ", rank_ ? "," : "", miss_->first.first, miss_->first.second);
+			Profile::index(file_, miss_->second.owner);
+			std::fprintf(file_, ", \"depth\": %u, \"count\": %llu, \"hot\": %s}", Profile::depth(miss_->first.first, miss_->second.owner),
+				static_cast<unsigned long long>(miss_->second.count), ++rank_ <= top_ ? "true" : "false");
+		}
+
+		std::fprintf(file_, "\n  ],\n  \"paths\": [");
+		rank_ = 0;
+		for (auto& path_: Profile::sorted(Profile::paths, Profile::paths.size()))
+		{
+			std::fprintf(file_, "%s\n    {\"from\": ", rank_ ? "," : "");
+			Profile::index(file_, path_->first.first);
+			std::fprintf(file_, ", \"to\": ");
+			Profile::index(file_, path_->first.second);
+			std::fprintf(file_, ", \"count\": %llu, \"hot\": %s}", static_cast<unsigned long long>(path_->second), ++rank_ <= top_ ? "true" : "false");
+		}
+
+		std::fprintf(file_, "\n  ]\n}\n");
+
+		return std::ferror(file_) == 0;
+	}
+
+/* -------------------------------------------------------------------------- */
+
+	private:
+	struct Counter
+	{
+		std::uint64_t count{}; // number of fired actions
+		std::uint64_t time{};  // total latency of fired actions (in clock ticks)
+	};
+
+	struct Visits
+	{
+		std::uint64_t entries{}; // number of entries to the state
+		std::uint64_t exits{};   // number of exits from the state
+	};
+
+	struct Miss
+	{
+		unsigned owner{none};    // state handling the event ('none' if not handled)
+		std::uint64_t count{};   // number of misses
+	};
+
+	struct Machine
+	{
+		unsigned state{none};    // current state of the traced hsm instance
+		unsigned action{none};   // open action of the last dispatched event
+		std::uint64_t start{};   // time of the action record
+		std::uint64_t last{};    // time of the last record of the hsm instance
+	};
+
+	const Definition& def;       // hsm definition of the traced hsm instances
+	double scale;                // duration of the clock tick in nanoseconds
+	std::vector<Counter> actions;// frequency and latency of each action
+	std::vector<Visits> states;  // entries and exits of each state
+	std::map<std::pair<unsigned, unsigned>, Miss> misses;           // misses for each current state and event
+	std::map<std::pair<unsigned, unsigned>, std::uint64_t> paths;   // number of transitions for each source and target state
+	std::uint64_t events{};      // number of user events
+
+/******************************************************************************
+ * Name              : hsm::Profile::close
+ * Description       : close the open action of the traced hsm instance
+ * Parameters        :
+ *           machine : traced hsm instance
+ *              time : time of the closing record
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void close( Machine& machine_, std::uint64_t time_ )
+	{
+		if (machine_.action == none)
+			return;
+
+		Profile::actions[machine_.action].count++;
+		Profile::actions[machine_.action].time += time_ - machine_.start;
+		machine_.action = none;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Profile::miss
+ * Description       : count the ancestor-walk miss
+ * Parameters        :
+ *             state : current state
+ *             event : event value
+ *             owner : state handling the event or 'none'
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void miss( unsigned state_, unsigned event_, unsigned owner_ )
+	{
+		Miss& miss_ = Profile::misses[{ state_, event_ }];
+		miss_.owner = owner_;
+		miss_.count++;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Profile::valid
+ * Description       : check the state index of the trace record
+ * Parameters        :
+ *             state : state index
+ * Return            : true if the state belongs to the definition
+ * Note              : for internal use
+ ******************************************************************************/
+
+	bool valid( unsigned state_ ) const
+	{
+		return state_ < Profile::states.size();
+	}
+
+/******************************************************************************
+ * Name              : hsm::Profile::depth
+ * Description       : get the number of ancestors walked by the miss
+ * Parameters        :
+ *             state : current state
+ *             owner : state handling the event or 'none'
+ * Return            : number of walked ancestors
+ * Note              : for internal use
+ ******************************************************************************/
+
+	unsigned depth( unsigned state_, unsigned owner_ ) const
+	{
+		return Profile::def.getLevel(state_) - (owner_ != none ? Profile::def.getLevel(owner_) : 0);
+	}
+
+/******************************************************************************
+ * Name              : hsm::Profile::latency
+ * Description       : get the average latency of the action
+ * Parameters        :
+ *           counter : counter of the action
+ * Return            : average latency in nanoseconds
+ * Note              : for internal use
+ ******************************************************************************/
+
+	double latency( const Counter& counter_ ) const
+	{
+		return counter_.count > 0 ? static_cast<double>(counter_.time) * Profile::scale / static_cast<double>(counter_.count) : 0.0;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Profile::threshold
+ * Description       : get the lowest frequency of the hottest actions
+ * Parameters        :
+ *               top : number of the hottest actions
+ * Return            : frequency of the last of the hottest actions
+ * Note              : for internal use
+ ******************************************************************************/
+
+	std::uint64_t threshold( std::size_t top_ ) const
+	{
+		std::vector<std::uint64_t> counts_;
+		for (const Counter& counter_: Profile::actions)
+			counts_.push_back(counter_.count);
+		std::sort(std::begin(counts_), std::end(counts_), []( std::uint64_t a_, std::uint64_t b_ ){ return a_ > b_; });
+
+		return top_ == 0 || counts_.empty() ? ~std::uint64_t{} : counts_[std::min(top_, counts_.size()) - 1];
+	}
+
+/******************************************************************************
+ * Name              : hsm::Profile::sorted
+ * Description       : get the most frequent items of the map
+ * Parameters        :
+ *               map : map of counted items
+ *               top : maximum number of items
+ * Return            : iterators of the items ordered by frequency
+ * Note              : for internal use
+ ******************************************************************************/
+
+	template<class M>
+	static std::vector<typename M::const_iterator> sorted( const M& map_, std::size_t top_ )
+	{
+		std::vector<typename M::const_iterator> items_;
+		for (auto item_ = std::begin(map_); item_ != std::end(map_); ++item_)
+			items_.push_back(item_);
+		std::stable_sort(std::begin(items_), std::end(items_), []( auto a_, auto b_ ){ return Profile::frequency(*a_) > Profile::frequency(*b_); });
+		items_.resize(std::min(top_, items_.size()));
+
+		return items_;
+	}
+
+	template<class K>
+	static std::uint64_t frequency( const std::pair<const K, Miss>& item_ ) { return item_.second.count; }
+	template<class K>
+	static std::uint64_t frequency( const std::pair<const K, std::uint64_t>& item_ ) { return item_.second; }
+
+/******************************************************************************
+ * Name              : hsm::Profile::getEvents
+ * Description       : get the event values handled by the action in the state tables of its owner
+ * Parameters        :
+ *            action : action index
+ * Return            : event values, Event::ALL if the action handles all events
+ * Note              : for internal use
+ ******************************************************************************/
+
+	std::vector<unsigned> getEvents( unsigned action_ ) const
+	{
+		const unsigned owner_ = Profile::def.getLink(action_).owner;
+		std::vector<unsigned> events_;
+		unsigned columns_ = 0;
+
+		for (unsigned column_ = 0; column_ < Profile::def.width; column_++)
+		{
+			for (unsigned item_ = Profile::def.getAction(owner_, column_); item_ != none; item_ = Profile::def.get(Profile::def.links[item_ * Definition::LinkSize + Definition::Next]))
+			{
+				if (item_ != action_)
+					continue;
+				if (column_ + 1 < Profile::def.width)
+					events_.push_back(Profile::def.values[column_]);
+				columns_++;
+				break;
+			}
+		}
+
+		if (columns_ == Profile::def.width)
+			return { Event::ALL };
+
+		return events_;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Profile::isHandled
+ * Description       : check if the action has the event handler
+ * Parameters        :
+ *            action : action index
+ * Return            : true if the action has the event handler
+ * Note              : for internal use
+ ******************************************************************************/
+
+	bool isHandled( unsigned action_ ) const
+	{
+		return Profile::def.get(Profile::def.links[action_ * Definition::LinkSize + Definition::Slot]) != none;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Profile::isDirect
+ * Description       : check if the transition path is covered by the direct transition of the definition
+ * Parameters        :
+ *             state : source state
+ *            target : target state
+ * Return            : true if any action of the source state or its ancestors targets the state
+ * Note              : for internal use
+ ******************************************************************************/
+
+	bool isDirect( unsigned state_, unsigned target_ ) const
+	{
+		for (unsigned action_ = 0; action_ < Profile::actions.size(); action_++)
+		{
+			const Definition::Link link_ = Profile::def.getLink(action_);
+			if (link_.target == target_ && Profile::def.getRoot(state_, link_.owner) == link_.owner)
+				return true;
+		}
+
+		return false;
+	}
+
+/******************************************************************************
+ * Name              : hsm::Profile::label
+ * Description       : write the event values of the action
+ * Parameters        :
+ *              file : output file
+ *            action : action index
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void label( std::FILE *file_, unsigned action_ ) const
+	{
+		const std::vector<unsigned> events_ = Profile::getEvents(action_);
+
+		for (std::size_t item_ = 0; item_ < events_.size(); item_++)
+		{
+			const char *separator_ = item_ ? "," : "";
+			switch (events_[item_])
+			{
+			case Event::ALL:   std::fprintf(file_, "%sALL",   separator_); break;
+			case Event::Exit:  std::fprintf(file_, "%sExit",  separator_); break;
+			case Event::Entry: std::fprintf(file_, "%sEntry", separator_); break;
+			case Event::Init:  std::fprintf(file_, "%sInit",  separator_); break;
+			default:           std::fprintf(file_, "%s%u", separator_, events_[item_]); break;
+			}
+		}
+	}
+
+/******************************************************************************
+ * Name              : hsm::Profile::index
+ * Description       : write the state index as JSON value
+ * Parameters        :
+ *              file : output file
+ *             state : state index or 'none'
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	static void index( std::FILE *file_, unsigned state_ )
+	{
+		if (state_ == none)
+			std::fprintf(file_, "null");
+		else
+			std::fprintf(file_, "%u", state_);
+	}
+};
+
+/* -------------------------------------------------------------------------- */
+
+}     //  namespace hsm
+
+#endif//__HSMPROFILE_HPP
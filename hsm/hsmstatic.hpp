@@ -0,0 +1,533 @@
+/******************************************************************************
+
+    @file    hsmstatic.hpp
+    @author  Rajmund Szymanski
+    @date    14.10.2026
+    @brief   This file contains definitions for compile-time hierachical state machine.
+
+ ******************************************************************************
+
+   Copyright (c) 2018-2026 Rajmund Szymanski. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+
+ ******************************************************************************/
+
+#ifndef __HSMSTATIC_HPP
+#define __HSMSTATIC_HPP
+
+#include <array>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <cassert>
+#include <cstddef>
+#include "hsm.hpp"
+
+namespace hsm {
+
+/******************************************************************************
+ *
+ * Class             : StaticState
+ *
+ * Description       : compile-time hsm state type; derive application states from it
+ *                     struct StateIdle     : hsm::StaticState<> {};
+ *                     struct StateIdleStop : hsm::StaticState<StateIdle> {};
+ *
+ * Template parameters
+ *            Parent : state parent in the hsm tree (void for the top-level state)
+ *
+ ******************************************************************************/
+
+template<class Parent = void>
+struct StaticState
+{
+	using parent = Parent;
+};
+
+/******************************************************************************
+ *
+ * Class             : StaticTransition
+ *
+ * Description       : compile-time hsm action: direct transition to the target state
+ *                     transition to the owner state consumes the event
+ *
+ * Template parameters
+ *             Owner : action owner state
+ *             Event : action event value
+ *            Target : transition target state
+ *
+ ******************************************************************************/
+
+template<class Owner, unsigned Event, class Target = Owner>
+struct StaticTransition
+{
+	using owner  = Owner;
+	using target = Target;
+	static constexpr unsigned event = Event;
+	static constexpr bool handler = false;
+
+	template<class M>
+	static constexpr bool transits = false;
+
+	template<class M>
+	static void call( M&, const Message& ) {}
+};
+
+/******************************************************************************
+ *
+ * Class             : StaticHandler
+ *
+ * Description       : compile-time hsm action: event handler
+ *                     the handler taking the hsm object can request the transition (see StaticStateMachine)
+ *
+ * Template parameters
+ *             Owner : action owner state
+ *             Event : action event value
+ *          Function : pointer to function or capture-less lambda (c++20) taking message,
+ *                     or capture-less generic lambda (c++20) taking the hsm object and message
+ *
+ ******************************************************************************/
+
+template<class Owner, unsigned Event, auto Function>
+struct StaticHandler
+{
+	using owner  = Owner;
+	using target = Owner;
+	static constexpr unsigned event = Event;
+	static constexpr bool handler = true;
+
+	template<class M>
+	static constexpr bool transits = std::is_invocable_v<decltype(Function), M&, const Message&>;
+
+	template<class M>
+	static void call( M& hsm_, const Message& message_ )
+	{
+		if constexpr (transits<M>)
+			Function(hsm_, message_);
+		else
+			Function(message_);
+	}
+};
+
+/******************************************************************************
+ *
+ * Class             : StaticList
+ *
+ * Description       : list of compile-time hsm states
+ * Note              : for internal use
+ *
+ ******************************************************************************/
+
+template<class... T>
+struct StaticList
+{
+	static constexpr unsigned size = sizeof...(T);
+
+	template<class S>
+	static constexpr bool contains = (std::is_same_v<S, T> || ...);
+
+	template<class S>
+	static constexpr unsigned indexOf()
+	{
+		constexpr bool same_[] = { std::is_same_v<S, T>..., true };
+		unsigned index_ = 0;
+		while (!same_[index_]) index_++;
+		return index_;
+	}
+
+	template<class S>
+	using insert = std::conditional_t<contains<S>, StaticList, StaticList<T..., S>>;
+};
+
+template<class L, class S, class = void>
+struct StaticInsert // insert state with all its ancestors, parents precede children
+{
+	using type = typename StaticInsert<L, typename S::parent>::type::template insert<S>;
+};
+
+template<class L, class S>
+struct StaticInsert<L, S, std::enable_if_t<std::is_void_v<S>>>
+{
+	using type = L;
+};
+
+template<class L, class... S>
+struct StaticCollect
+{
+	using type = L;
+};
+
+template<class L, class S, class... R>
+struct StaticCollect<L, S, R...>
+{
+	using type = typename StaticCollect<typename StaticInsert<L, S>::type, R...>::type;
+};
+
+/******************************************************************************
+ *
+ * Class             : StaticStateMachine
+ *
+ * Description       : compile-time hierarchical state machine object
+ *                     the set of states, the dispatch tables, the transition paths,
+ *                     and the Init chains are resolved by the compiler;
+ *                     handlers are called directly and can be inlined
+ *                     the action table has the same meaning as for hsm::StateMachine:
+ *                     the last matching action of the state is the assigned one
+ *                     no memory is allocated, the object keeps only the current state index
+ *                     and the index of the requested transition target
+ *                     the 'hsm' field of the message passed to the event handler is not set;
+ *                     the event handler taking the hsm object can request the transition
+ *                     with the function 'transition', as for hsm::StateMachine;
+ *                     each state tests only the user events it handles
+ *
+ * Template parameters
+ *           Actions : set of compile-time hsm actions (StaticTransition / StaticHandler)
+ *
+ ******************************************************************************/
+
+template<class... Actions>
+struct StaticStateMachine
+{
+	private:
+	using States = typename StaticCollect<StaticList<>, typename Actions::owner..., typename Actions::target...>::type;
+
+	template<class S>
+	static constexpr unsigned index = States::template indexOf<S>();
+
+	static constexpr unsigned none  = States::size;           // index of the 'no state'
+	static constexpr std::size_t count = sizeof...(Actions);  // number of actions, index of the 'no action'
+
+	template<class L> struct Parents;
+	template<class... S> struct Parents<StaticList<S...>> { static constexpr unsigned value[] = { index<typename S::parent>..., none }; };
+
+	static constexpr auto& parents = Parents<States>::value;
+	static constexpr unsigned owners[]  = { index<typename Actions::owner>..., none };
+	static constexpr unsigned targets[] = { index<typename Actions::target>..., none };
+	static constexpr unsigned events[]  = { Actions::event..., Event::ALL };
+	static constexpr bool     handlers[]= { Actions::handler..., false };
+
+	template<std::size_t A>
+	using ActionAt = std::tuple_element_t<A, std::tuple<Actions...>>;
+
+	using Index = std::conditional_t<(none < 0xFF), unsigned char, std::conditional_t<(none < 0xFFFF), unsigned short, unsigned>>;
+
+	static constexpr unsigned keep = none + 1;                // index of the 'no transition requested'
+
+	Index state = static_cast<Index>(none); // index of the current hsm state
+	Index next  = static_cast<Index>(keep); // index of the transition target requested by the event handler
+
+/* -------------------------------------------------------------------------- */
+
+	static constexpr unsigned getLevel( unsigned state_ )
+	{
+		unsigned level_ = 0;
+
+		while (state_ != none)
+		{
+			level_++;
+			state_ = parents[state_];
+		}
+
+		return level_;
+	}
+
+	static constexpr unsigned getRoot( unsigned state_, unsigned other_ )
+	{
+		unsigned level_ = StaticStateMachine::getLevel(state_);
+		unsigned other_level_ = StaticStateMachine::getLevel(other_);
+
+		while (level_ > other_level_) { state_ = parents[state_]; level_--; }
+		while (other_level_ > level_) { other_ = parents[other_]; other_level_--; }
+		while (state_ != other_)
+		{
+			state_ = parents[state_];
+			other_ = parents[other_];
+		}
+
+		return state_;
+	}
+
+	static constexpr unsigned getNext( unsigned state_, unsigned sign_ )
+	{
+		while (parents[sign_] != state_)
+			sign_ = parents[sign_];
+
+		return sign_;
+	}
+
+	static constexpr std::size_t getAction( unsigned state_, unsigned event_ )
+	{
+		for (std::size_t action_ = count; action_-- > 0; )
+			if (owners[action_] == state_ && (events[action_] == event_ || events[action_] == Event::ALL))
+				return action_;
+
+		return count;
+	}
+
+	static constexpr std::size_t findAction( unsigned state_, unsigned event_ )
+	{
+		std::size_t action_ = StaticStateMachine::getAction(state_, event_);
+
+		while (action_ == count && state_ != none && event_ >= Event::User)
+		{
+			state_ = parents[state_];
+			action_ = StaticStateMachine::getAction(state_, event_);
+		}
+
+		return action_;
+	}
+
+	static constexpr unsigned getOther()
+	{
+		unsigned event_ = Event::User;
+
+		for (auto value_: events)
+			if (event_ <= value_) event_ = value_ + 1;
+
+		return event_;
+	}
+
+	static constexpr bool isHandled( unsigned state_, std::size_t action_ ) // the first action of the user event resolved in the state differently than other events
+	{
+		if (events[action_] < Event::User || StaticStateMachine::findAction(state_, events[action_]) == StaticStateMachine::findAction(state_, StaticStateMachine::getOther()))
+			return false;
+
+		for (std::size_t other_ = 0; other_ < action_; other_++)
+			if (events[other_] == events[action_])
+				return false;
+
+		return true;
+	}
+
+	static constexpr std::size_t getHandled( unsigned state_ )
+	{
+		std::size_t size_ = 0;
+
+		for (std::size_t action_ = 0; action_ < count; action_++)
+			if (StaticStateMachine::isHandled(state_, action_))
+				size_++;
+
+		return size_;
+	}
+
+	template<unsigned S>
+	static constexpr auto getHandled()
+	{
+		std::array<std::size_t, StaticStateMachine::getHandled(S)> list_{};
+		std::size_t size_ = 0;
+
+		for (std::size_t action_ = 0; action_ < count; action_++)
+			if (StaticStateMachine::isHandled(S, action_))
+				list_[size_++] = action_;
+
+		return list_;
+	}
+
+	template<unsigned S>
+	static constexpr auto handled = StaticStateMachine::getHandled<S>(); // actions of the user events tested in the state
+
+/* -------------------------------------------------------------------------- */
+
+	template<unsigned S, unsigned E>
+	void callHandler( const Message& message_ )
+	{
+		constexpr std::size_t A = StaticStateMachine::getAction(S, E);
+
+		if constexpr (A < count)
+		{
+			ActionAt<A>::call(*this, {message_, E});
+			assert(StaticStateMachine::next == keep); // the Exit and Entry event handlers must not change the state
+		}
+	}
+
+	template<unsigned S, unsigned R>
+	void exit( const Message& message_ )
+	{
+		if constexpr (S != R)
+		{
+			StaticStateMachine::callHandler<S, Event::Exit>(message_);
+			StaticStateMachine::exit<parents[S], R>(message_);
+		}
+	}
+
+	template<unsigned R, unsigned T>
+	void entry( const Message& message_ )
+	{
+		if constexpr (R != T)
+		{
+			constexpr unsigned C = StaticStateMachine::getNext(R, T);
+
+			StaticStateMachine::callHandler<C, Event::Entry>(message_);
+			StaticStateMachine::entry<C, T>(message_);
+		}
+	}
+
+	template<unsigned S, unsigned T>
+	void transition( const Message& message_ )
+	{
+		StaticStateMachine::exit<S, StaticStateMachine::getRoot(S, T)>(message_);
+		StaticStateMachine::entry<StaticStateMachine::getRoot(S, T), T>(message_);
+		StaticStateMachine::state = static_cast<Index>(T);
+
+		if constexpr (T != none)
+			StaticStateMachine::callAction<T, StaticStateMachine::getAction(T, Event::Init)>({message_, Event::Init});
+	}
+
+	template<unsigned S, std::size_t A>
+	void callAction( const Message& message_ )
+	{
+		if constexpr (A < count)
+		{
+			if constexpr (handlers[A])
+			{
+				ActionAt<A>::call(*this, message_);
+
+				if constexpr (ActionAt<A>::template transits<StaticStateMachine>)
+				{
+					const unsigned next_ = StaticStateMachine::next;
+					StaticStateMachine::next = static_cast<Index>(keep);
+
+					if (next_ != keep && next_ != owners[A])
+					{
+						assert(events[A] != Event::Init || parents[next_] == S); // Init transition must target a child state
+						(this->*transitions<S>[next_])(message_);
+					}
+				}
+			}
+			else
+			if constexpr (targets[A] != owners[A])
+			{
+				static_assert(events[A] != Event::Init || parents[targets[A]] == S, "Init transition must target a child state");
+				StaticStateMachine::transition<S, targets[A]>(message_);
+			}
+		}
+	}
+
+	template<unsigned S, std::size_t A>
+	bool eventAction( const Message& message_ )
+	{
+		if (message_.event != events[A])
+			return false;
+
+		StaticStateMachine::callAction<S, StaticStateMachine::findAction(S, events[A])>(message_);
+		return true;
+	}
+
+	template<unsigned S, std::size_t... I>
+	void eventHandler( const Message& message_, std::index_sequence<I...> )
+	{
+		if (!(false || ... || StaticStateMachine::eventAction<S, handled<S>[I]>(message_)))
+			StaticStateMachine::callAction<S, StaticStateMachine::findAction(S, StaticStateMachine::getOther())>(message_);
+	}
+
+	template<unsigned S>
+	static void dispatch( StaticStateMachine& hsm_, const Message& message_ )
+	{
+		if constexpr (S != none)
+		{
+			if (message_.event == Event::Stop)
+				hsm_.template transition<S, none>({});
+			else
+				hsm_.template eventHandler<S>(message_, std::make_index_sequence<handled<S>.size()>{});
+		}
+	}
+
+	template<unsigned S, unsigned... T>
+	static constexpr auto getTransitions( std::integer_sequence<unsigned, T...> )
+	{
+		return std::array<void (StaticStateMachine::*)( const Message& ), sizeof...(T)>{{ &StaticStateMachine::transition<S, T>... }};
+	}
+
+	template<unsigned S>
+	static constexpr auto transitions = StaticStateMachine::getTransitions<S>(std::make_integer_sequence<unsigned, none>{});
+
+	template<std::size_t... S>
+	static constexpr auto getTable( std::index_sequence<S...> )
+	{
+		return std::array<void (*)( StaticStateMachine&, const Message& ), sizeof...(S)>{{ &StaticStateMachine::dispatch<S>... }};
+	}
+
+	static constexpr auto table = StaticStateMachine::getTable(std::make_index_sequence<none + 1>{});
+
+/* -------------------------------------------------------------------------- */
+
+	public:
+	constexpr StaticStateMachine() {}
+
+/******************************************************************************
+ * Name              : hsm::StaticStateMachine::start
+ * Description       : start compile-time hierarchical state machine
+ * Template parameters
+ *              Init : initial hsm state
+ * Return            : none
+ ******************************************************************************/
+
+	template<class Init>
+	void start()
+	{
+		static_assert(index<Init> != none, "initial state is not used by the hsm");
+		static_assert(std::is_void_v<typename Init::parent>, "initial state must be the top-level state");
+		assert(StaticStateMachine::state == none);
+
+		if (StaticStateMachine::state == none)
+			StaticStateMachine::transition<none, index<Init>>({});
+	}
+
+/******************************************************************************
+ * Name              : hsm::StaticStateMachine::message
+ * Description       : handle given user message
+ * Parameters        :
+ *               msg : message
+ * Return            : none
+ ******************************************************************************/
+
+	void message( const Message& message_ )
+	{
+		assert(StaticStateMachine::state != none);
+		assert(message_.event == Event::Stop || message_.event >= Event::User);
+
+		StaticStateMachine::table[StaticStateMachine::state](*this, message_);
+	}
+
+/******************************************************************************
+ * Name              : hsm::StaticStateMachine::transition
+ * Description       : request the transition to the given target state from the event handler
+ *                     the transition is done when the event handler returns;
+ *                     the transition to the owner state of the event handler is ignored
+ * Template parameters
+ *            Target : transition target state
+ * Return            : none
+ * Note              : call only from the event handler taking the hsm object, not from Exit and Entry
+ ******************************************************************************/
+
+	template<class Target>
+	void transition()
+	{
+		static_assert(index<Target> != none, "transition target is not used by the hsm");
+
+		StaticStateMachine::next = static_cast<Index>(index<Target>);
+	}
+};
+
+/* -------------------------------------------------------------------------- */
+
+}     //  namespace hsm
+
+#endif//__HSMSTATIC_HPP
@@ -0,0 +1,377 @@
+/******************************************************************************
+
+    @file    hsmtimer.hpp
+    @author  Rajmund Szymanski
+    @date    14.10.2026
+    @brief   This file contains definitions of the hierarchical timer wheel for hsm.
+
+ ******************************************************************************
+
+   Copyright (c) 2018-2026 Rajmund Szymanski. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+
+ ******************************************************************************/
+
+
+#ifndef __HSMTIMER_HPP
+#define __HSMTIMER_HPP
+
+#include <memory_resource>
+#include <vector>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include "hsmconfig.hpp"
+
+namespace hsm {
+
+/******************************************************************************
+ *
+ * Class             : TimerWheel
+ *
+ * Description       : hierarchical timing wheel shared by any number of hsm instances
+ *                     four levels of 64 slots each cover 2^24 ticks, longer delays are re-cascaded;
+ *                     arming and disarming are O(1) and never allocate memory
+ *                     expired timers of the tick are collected first and then delivered
+ *                     in batch; the timer disarmed by the delivery of another one is not delivered
+ *
+ * Constructor parameters
+ *          capacity : maximum number of armed timers
+ *          resource : memory resource providing the storage of timers
+ *                     (default: hsm::defaultResource())
+ *
+ ******************************************************************************/
+
+struct TimerWheel
+{
+	static constexpr unsigned none = ~0U; // index of the 'no timer'
+
+	using Callback = void (*)( void *context, unsigned tag ); // function notified of the expired timer
+
+	TimerWheel( std::size_t capacity_, std::pmr::memory_resource *resource_ = defaultResource() ):
+		timers(capacity_, resource_)
+	{
+		assert(capacity_ < none);
+
+		for (auto& head_: TimerWheel::heads)
+			head_ = none;
+		for (unsigned timer_ = 0; timer_ < capacity_; timer_++)
+			TimerWheel::timers[timer_].next = timer_ + 1 < capacity_ ? timer_ + 1 : none;
+		TimerWheel::spare = capacity_ > 0 ? 0 : none;
+	}
+
+	TimerWheel( TimerWheel&& ) = delete;
+	TimerWheel( const TimerWheel& ) = delete;
+	TimerWheel& operator=( TimerWheel&& ) = delete;
+	TimerWheel& operator=( const TimerWheel& ) = delete;
+
+/******************************************************************************
+ * Name              : hsm::TimerWheel::arm
+ * Description       : arm the timer expiring after the given number of ticks
+ * Parameters        :
+ *             delay : number of ticks (at least 1)
+ *          function : function notified of the expired timer
+ *           context : context pointer passed to the function
+ *               tag : value passed to the function
+ * Return            : index of the armed timer or 'none' if all timers are armed
+ ******************************************************************************/
+
+	unsigned arm( unsigned delay_, Callback function_, void *context_, unsigned tag_ )
+	{
+		unsigned timer_ = TimerWheel::spare;
+
+		if (timer_ == none)
+			return none;
+
+		Timer& item_ = TimerWheel::timers[timer_];
+		TimerWheel::spare = item_.next;
+		item_.expiry   = TimerWheel::clock + (delay_ > 0 ? delay_ : 1);
+		item_.function = function_;
+		item_.context  = context_;
+		item_.tag      = tag_;
+		TimerWheel::insert(timer_);
+		TimerWheel::count++;
+
+		return timer_;
+	}
+
+/******************************************************************************
+ * Name              : hsm::TimerWheel::disarm
+ * Description       : disarm the armed timer
+ * Parameters        :
+ *             timer : index of the timer returned by the function 'arm'
+ * Return            : none
+ ******************************************************************************/
+
+	void disarm( unsigned timer_ )
+	{
+		assert(timer_ < TimerWheel::timers.size() && TimerWheel::timers[timer_].list != none);
+
+		TimerWheel::unlink(timer_);
+		TimerWheel::release(timer_);
+	}
+
+/******************************************************************************
+ * Name              : hsm::TimerWheel::rebind
+ * Description       : change the context pointer of the armed timer
+ * Parameters        :
+ *             timer : index of the timer returned by the function 'arm'
+ *           context : new context pointer passed to the function
+ * Return            : none
+ ******************************************************************************/
+
+	void rebind( unsigned timer_, void *context_ )
+	{
+		assert(timer_ < TimerWheel::timers.size() && TimerWheel::timers[timer_].list != none);
+
+		TimerWheel::timers[timer_].context = context_;
+	}
+
+/******************************************************************************
+ * Name              : hsm::TimerWheel::advance
+ * Description       : advance the time of the wheel and notify the expired timers
+ *                     timers expired in each tick are notified in batch
+ * Parameters        :
+ *             ticks : number of ticks
+ * Return            : number of notified timers
+ ******************************************************************************/
+
+	std::size_t advance( std::uint64_t ticks_ )
+	{
+		std::size_t delivered_ = 0;
+
+		for (; ticks_ > 0; ticks_--)
+		{
+			if (TimerWheel::count == 0)
+			{
+				TimerWheel::clock += ticks_;
+				break;
+			}
+
+			const std::uint64_t clock_ = ++TimerWheel::clock;
+
+			// slots of higher levels are cascaded when all lower levels wrap around, the highest level first
+			unsigned level_ = 1;
+			while (level_ < Levels && (clock_ & ((std::uint64_t{1} << (Bits * level_)) - 1)) == 0)
+				level_++;
+			while (--level_ > 0)
+				TimerWheel::cascade(level_ * Slots + static_cast<unsigned>((clock_ >> (Bits * level_)) & (Slots - 1)));
+
+			const unsigned slot_ = static_cast<unsigned>(clock_ & (Slots - 1));
+			while (TimerWheel::heads[slot_] != none)
+			{
+				unsigned timer_ = TimerWheel::heads[slot_];
+				TimerWheel::unlink(timer_);
+				TimerWheel::link(timer_, Expired);
+			}
+
+			while (TimerWheel::heads[Expired] != none)
+			{
+				unsigned timer_ = TimerWheel::heads[Expired];
+				const Timer item_ = TimerWheel::timers[timer_];
+				TimerWheel::unlink(timer_);
+				TimerWheel::release(timer_);
+				item_.function(item_.context, item_.tag);
+				delivered_++;
+			}
+		}
+
+		return delivered_;
+	}
+
+/******************************************************************************
+ * Name              : hsm::TimerWheel::now
+ * Description       : get the current time of the wheel
+ * Parameters        : none
+ * Return            : number of ticks advanced since construction
+ ******************************************************************************/
+
+	std::uint64_t now() const
+	{
+		return TimerWheel::clock;
+	}
+
+/******************************************************************************
+ * Name              : hsm::TimerWheel::size
+ * Description       : get number of armed timers
+ * Parameters        : none
+ * Return            : number of armed timers
+ ******************************************************************************/
+
+	std::size_t size() const
+	{
+		return TimerWheel::count;
+	}
+
+/* -------------------------------------------------------------------------- */
+
+	private:
+	static constexpr unsigned Bits    = 6;                     // number of bits of the slot index
+	static constexpr unsigned Slots   = 1U << Bits;            // number of slots of each level
+	static constexpr unsigned Levels  = 4;                     // number of levels
+	static constexpr unsigned Expired = Levels * Slots;        // list of expired timers waiting for delivery
+
+	struct Timer
+	{
+		std::uint64_t expiry{};  // time of expiration
+		Callback function{};     // function notified of the expiration
+		void    *context{};      // context pointer passed to the function
+		unsigned tag{};          // value passed to the function
+		unsigned prev{none};     // previous timer in the list
+		unsigned next{none};     // next timer in the list or in the set of spare timers
+		unsigned list{none};     // list containing the armed timer
+	};
+
+	std::pmr::vector<Timer> timers;        // storage of timers
+	unsigned heads[Levels * Slots + 1];    // first timer of each slot and of the list of expired timers
+	unsigned spare{none};                  // first spare timer
+	std::size_t count{};                   // number of armed timers
+	std::uint64_t clock{};                 // current time
+
+/******************************************************************************
+ * Name              : hsm::TimerWheel::insert
+ * Description       : put the timer into the slot of its expiration time
+ *                     the timer with the delay beyond the range of the wheel is put into the last slot
+ *                     of the highest level to be cascaded before
+ * Parameters        :
+ *             timer : index of the timer
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void insert( unsigned timer_ )
+	{
+		const std::uint64_t expiry_ = TimerWheel::timers[timer_].expiry;
+		const std::uint64_t delay_ = expiry_ > TimerWheel::clock ? expiry_ - TimerWheel::clock : 0;
+
+		unsigned level_ = 0;
+		while (level_ + 1 < Levels && delay_ >= (std::uint64_t{1} << (Bits * (level_ + 1))))
+			level_++;
+
+		std::uint64_t slot_ = delay_ >= (std::uint64_t{1} << (Bits * Levels)) ? (TimerWheel::clock >> (Bits * level_)) + Slots - 1 : expiry_ >> (Bits * level_);
+		TimerWheel::link(timer_, level_ * Slots + static_cast<unsigned>(slot_ & (Slots - 1)));
+	}
+
+/******************************************************************************
+ * Name              : hsm::TimerWheel::cascade
+ * Description       : move the timers of the slot of the higher level to the lower levels
+ * Parameters        :
+ *              list : index of the slot
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void cascade( unsigned list_ )
+	{
+		const unsigned first_ = TimerWheel::heads[list_];
+
+		if (first_ == none)
+			return;
+
+		TimerWheel::heads[list_] = none;
+
+		unsigned timer_ = first_;
+		do
+		{
+			unsigned next_ = TimerWheel::timers[timer_].next;
+			TimerWheel::insert(timer_);
+			timer_ = next_;
+		}
+		while (timer_ != first_);
+	}
+
+/******************************************************************************
+ * Name              : hsm::TimerWheel::link
+ * Description       : append the timer to the circular list
+ * Parameters        :
+ *             timer : index of the timer
+ *              list : index of the list
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void link( unsigned timer_, unsigned list_ )
+	{
+		Timer& item_ = TimerWheel::timers[timer_];
+		unsigned& head_ = TimerWheel::heads[list_];
+
+		item_.list = list_;
+
+		if (head_ == none)
+		{
+			item_.prev = item_.next = head_ = timer_;
+			return;
+		}
+
+		item_.next = head_;
+		item_.prev = TimerWheel::timers[head_].prev;
+		TimerWheel::timers[item_.prev].next = timer_;
+		TimerWheel::timers[head_].prev = timer_;
+	}
+
+/******************************************************************************
+ * Name              : hsm::TimerWheel::unlink
+ * Description       : remove the timer from its list
+ * Parameters        :
+ *             timer : index of the timer
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void unlink( unsigned timer_ )
+	{
+		Timer& item_ = TimerWheel::timers[timer_];
+		unsigned& head_ = TimerWheel::heads[item_.list];
+
+		if (item_.next == timer_)
+			head_ = none;
+		else
+		{
+			TimerWheel::timers[item_.prev].next = item_.next;
+			TimerWheel::timers[item_.next].prev = item_.prev;
+			if (head_ == timer_)
+				head_ = item_.next;
+		}
+
+		item_.list = none;
+	}
+
+/******************************************************************************
+ * Name              : hsm::TimerWheel::release
+ * Description       : return the unlinked timer to the set of spare timers
+ * Parameters        :
+ *             timer : index of the timer
+ * Return            : none
+ * Note              : for internal use
+ ******************************************************************************/
+
+	void release( unsigned timer_ )
+	{
+		TimerWheel::timers[timer_].next = TimerWheel::spare;
+		TimerWheel::spare = timer_;
+		TimerWheel::count--;
+	}
+};
+
+/* -------------------------------------------------------------------------- */
+
+}     //  namespace hsm
+
+#endif//__HSMTIMER_HPP
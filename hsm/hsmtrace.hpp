@@ -0,0 +1,402 @@
+/******************************************************************************
+
+    @file    hsmtrace.hpp
+    @author  Rajmund Szymanski
+    @date    14.10.2026
+    @brief   This file contains definitions of the binary trace recorder for hsm.
+
+ ******************************************************************************
+
+   Copyright (c) 2018-2026 Rajmund Szymanski. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+
+ ******************************************************************************/
+
+#ifndef __HSMTRACE_HPP
+#define __HSMTRACE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include "hsmconfig.hpp"
+
+#ifndef HSM_TRACE_CLOCK
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define HSM_TRACE_CLOCK() __rdtsc()
+#define HSM_TRACE_RDTSC // the tick is calibrated against std::chrono::steady_clock
+#elif defined(HSM_CYCLES)
+#define HSM_TRACE_CLOCK() static_cast<std::uint64_t>(HSM_CYCLES())
+#else
+#define HSM_TRACE_CLOCK() static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count())
+#define HSM_TRACE_STEADY
+#endif
+#endif
+
+#if defined(HSM_FREESTANDING) && !defined(HSM_TRACE_BUFFERS)
+#define HSM_TRACE_BUFFERS 1
+#endif
+
+namespace hsm {
+
+/******************************************************************************
+ *
+ * Enum              : TraceKind
+ *
+ * Description       : kind of the hsm trace record
+ *
+ ******************************************************************************/
+
+enum class TraceKind: std::uint16_t
+{
+	Action,     // user event handled by the action of the state
+	Unhandled,  // user event not handled by the hsm
+	Transition, // transition from the state to the target state (data)
+	Exit,       // exit event handler of the state
+	Entry,      // entry event handler of the state
+	Init,       // init action of the state
+};
+
+/******************************************************************************
+ *
+ * Class             : TraceRecord
+ *
+ * Description       : fixed-size binary hsm trace record
+ *
+ ******************************************************************************/
+
+struct TraceRecord
+{
+	std::uint64_t time;    // timestamp (HSM_TRACE_CLOCK)
+	std::uint64_t machine; // address of the hsm object
+	std::uint32_t state;   // index of the state in the hsm definition
+	std::uint32_t event;   // event value of the message
+	std::uint32_t data;    // index of the target state (Transition) or action (Action, Init)
+	std::uint16_t kind;    // TraceKind
+	std::uint16_t thread;  // index of the trace buffer of the recording thread
+};
+
+static_assert(sizeof(TraceRecord) == 32, "unexpected size of the trace record");
+
+/******************************************************************************
+ *
+ * Class             : TraceHeader
+ *
+ * Description       : header of the binary trace file written by the function 'hsm::Trace::save'
+ *                     the header is followed by 'count' trace records
+ *
+ ******************************************************************************/
+
+struct TraceHeader
+{
+	char          magic[4]{'H', 'S', 'M', 'T'}; // file signature
+	std::uint32_t version{1};                   // file format version
+	std::uint32_t size{sizeof(TraceRecord)};    // size of the trace record
+	std::uint32_t tick{};                       // duration of the clock tick (in picoseconds, 0 if unknown)
+	std::uint64_t count{};                      // number of trace records
+};
+
+/******************************************************************************
+ *
+ * Class             : TraceBuffer
+ *
+ * Description       : lock-free ring buffer of trace records written by one thread
+ *                     the buffer keeps the last HSM_TRACE (default: 1024) records
+ *                     buffers are never freed; the buffer of the finished thread
+ *                     is reused by the next thread
+ *                     with HSM_TRACE_BUFFERS defined the buffers are taken from the static pool
+ *                     of that size instead of the heap
+ *
+ ******************************************************************************/
+
+struct TraceBuffer
+{
+#ifdef HSM_TRACE
+	static constexpr std::uint64_t capacity = HSM_TRACE;
+#else
+	static constexpr std::uint64_t capacity = 1024;
+#endif
+	static_assert(capacity > 0 && (capacity & (capacity - 1)) == 0, "capacity of the trace buffer must be a power of two");
+
+	TraceRecord records[capacity];         // storage of trace records
+	std::atomic<std::uint64_t> head{};     // number of records written to the buffer
+	std::atomic<bool> used{true};          // the buffer is owned by a thread
+	TraceBuffer *next{};                   // next buffer in the list of all buffers
+	std::uint16_t thread{};                // index of the buffer
+};
+
+/******************************************************************************
+ *
+ * Class             : Trace
+ *
+ * Description       : hsm trace recorder
+ *                     the hsm records its activity with HSM_TRACE defined
+ *                     (capacity of the per-thread ring buffer, a power of two)
+ *                     the timestamp is taken with HSM_TRACE_CLOCK(), by default the cycle counter:
+ *                     __rdtsc() on x86 (the tick is calibrated against std::chrono::steady_clock
+ *                     when the trace is saved), HSM_CYCLES() if defined (the tick is HSM_TRACE_TICK
+ *                     or unknown) or std::chrono::steady_clock otherwise
+ *                     with HSM_TRACE_BUFFERS defined as 1 (the default of the freestanding profile)
+ *                     only one thread may record and no thread local storage is used
+ *
+ ******************************************************************************/
+
+struct Trace
+{
+/******************************************************************************
+ * Name              : hsm::Trace::record
+ * Description       : write the trace record to the ring buffer of the calling thread
+ * Parameters        :
+ *              kind : kind of the record
+ *           machine : recording hsm
+ *             state : index of the state
+ *             event : event value
+ *              data : additional data
+ * Return            : none
+ ******************************************************************************/
+
+	static void record( TraceKind kind_, const void *machine_, unsigned state_, unsigned event_, unsigned data_ )
+	{
+		TraceBuffer& buffer_ = Trace::buffer();
+		std::uint64_t head_ = buffer_.head.load(std::memory_order_relaxed);
+		TraceRecord& record_ = buffer_.records[head_ & (TraceBuffer::capacity - 1)];
+
+		record_.time    = HSM_TRACE_CLOCK();
+		record_.machine = reinterpret_cast<std::uintptr_t>(machine_);
+		record_.state   = state_;
+		record_.event   = event_;
+		record_.data    = data_;
+		record_.kind    = static_cast<std::uint16_t>(kind_);
+		record_.thread  = buffer_.thread;
+
+		buffer_.head.store(head_ + 1, std::memory_order_release);
+	}
+
+/******************************************************************************
+ * Name              : hsm::Trace::collect
+ * Description       : pass the records of all trace buffers to the given function
+ *                     records of each buffer are passed from the oldest to the newest
+ * Parameters        :
+ *          function : function called for each record: void(const TraceRecord&)
+ * Return            : none
+ * Note              : records written concurrently with the function may be torn
+ ******************************************************************************/
+
+	template<class F>
+	static void collect( F&& function_ )
+	{
+		for (TraceBuffer *buffer_ = Trace::list().load(std::memory_order_acquire); buffer_ != nullptr; buffer_ = buffer_->next)
+		{
+			std::uint64_t head_ = buffer_->head.load(std::memory_order_acquire);
+			std::uint64_t tail_ = head_ > TraceBuffer::capacity ? head_ - TraceBuffer::capacity : 0;
+
+			while (tail_ < head_)
+				function_(buffer_->records[tail_++ & (TraceBuffer::capacity - 1)]);
+		}
+	}
+
+/******************************************************************************
+ * Name              : hsm::Trace::clear
+ * Description       : discard the records of all trace buffers
+ * Parameters        : none
+ * Return            : none
+ * Note              : call when no thread is recording
+ ******************************************************************************/
+
+	static void clear()
+	{
+		for (TraceBuffer *buffer_ = Trace::list().load(std::memory_order_acquire); buffer_ != nullptr; buffer_ = buffer_->next)
+			buffer_->head.store(0, std::memory_order_release);
+	}
+
+/******************************************************************************
+ * Name              : hsm::Trace::save
+ * Description       : write the trace header and the records of all trace buffers to the file
+ * Parameters        :
+ *              file : binary output file
+ *              tick : duration of the clock tick (in picoseconds, 0 if unknown)
+ * Return            : true if the trace has been written successfully
+ ******************************************************************************/
+
+	static bool save( std::FILE *file_, std::uint32_t tick_ = Trace::tick() )
+	{
+		TraceHeader header_;
+		Trace::collect([&header_]( const TraceRecord& ){ header_.count++; });
+		header_.tick = tick_;
+
+		bool result_ = std::fwrite(&header_, sizeof(header_), 1, file_) == 1;
+		std::uint64_t count_ = 0;
+
+		Trace::collect([&]( const TraceRecord& record_ ){
+			if (result_ && count_ < header_.count)
+				result_ = std::fwrite(&record_, sizeof(record_), 1, file_) == 1;
+			count_++;
+		});
+
+		return result_ && count_ >= header_.count;
+	}
+
+/* -------------------------------------------------------------------------- */
+
+	private:
+	struct Sample
+	{
+		static Sample now()
+		{
+			return { HSM_TRACE_CLOCK(), static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count()) };
+		}
+
+		std::uint64_t cycles; // timestamp of the trace clock
+		std::uint64_t time;   // timestamp of std::chrono::steady_clock (in nanoseconds)
+	};
+
+	struct Owner
+	{
+		Owner(): buffer{Trace::acquire()} {}
+	   ~Owner() { buffer->used.store(false, std::memory_order_release); }
+
+		TraceBuffer *buffer;
+	};
+
+	static std::atomic<TraceBuffer *>& list()
+	{
+		static std::atomic<TraceBuffer *> list_{};
+		return list_;
+	}
+
+	static TraceBuffer& buffer()
+	{
+#if defined(HSM_TRACE_BUFFERS) && HSM_TRACE_BUFFERS == 1
+		static TraceBuffer *const buffer_ = Trace::acquire();
+		return *buffer_;
+#else
+		static thread_local TraceBuffer *buffer_{}; // constant initialized, no call to the thread local wrapper
+		if (buffer_ == nullptr)
+			buffer_ = Trace::owner();
+		return *buffer_;
+#endif
+	}
+
+	static TraceBuffer* owner()
+	{
+		static thread_local Owner owner_;
+		return owner_.buffer;
+	}
+
+	static const Sample& origin()
+	{
+		static const Sample origin_ = Sample::now();
+		return origin_;
+	}
+
+	static std::uint32_t tick()
+	{
+#if defined(HSM_TRACE_TICK)
+		return HSM_TRACE_TICK;
+#elif defined(HSM_TRACE_RDTSC)
+		return Trace::calibrate();
+#elif defined(HSM_TRACE_STEADY)
+		using period = std::chrono::steady_clock::period;
+		return static_cast<std::uint32_t>(period::num * 1000000000000 / period::den);
+#else
+		return 0;
+#endif
+	}
+
+/******************************************************************************
+ * Name              : hsm::Trace::calibrate
+ * Description       : measure the duration of the tick of the trace clock against std::chrono::steady_clock
+ *                     since the first trace buffer has been acquired (at least 10 ms)
+ * Parameters        : none
+ * Return            : duration of the clock tick (in picoseconds, 0 if unknown)
+ * Note              : for internal use
+ ******************************************************************************/
+
+	static std::uint32_t calibrate()
+	{
+		const Sample& origin_ = Trace::origin();
+		Sample now_;
+
+		do now_ = Sample::now();
+		while (now_.time - origin_.time < 10000000);
+
+		const std::uint64_t cycles_ = now_.cycles - origin_.cycles;
+
+		return cycles_ == 0 ? 0 : static_cast<std::uint32_t>(((now_.time - origin_.time) * 1000 + cycles_ / 2) / cycles_);
+	}
+
+/******************************************************************************
+ * Name              : hsm::Trace::acquire
+ * Description       : reuse the trace buffer released by the finished thread
+ *                     or allocate (take from the static pool) and register a new one
+ * Parameters        : none
+ * Return            : trace buffer of the calling thread
+ * Note              : for internal use; the exhausted pool is fatal
+ ******************************************************************************/
+
+	static TraceBuffer* acquire()
+	{
+#ifdef HSM_TRACE_RDTSC
+		Trace::origin();
+#endif
+		TraceBuffer *head_ = Trace::list().load(std::memory_order_acquire);
+
+		for (TraceBuffer *buffer_ = head_; buffer_ != nullptr; buffer_ = buffer_->next)
+		{
+			bool used_ = false;
+			if (!buffer_->used.load(std::memory_order_relaxed) && buffer_->used.compare_exchange_strong(used_, true, std::memory_order_acquire))
+				return buffer_;
+		}
+
+#ifdef HSM_TRACE_BUFFERS
+		static TraceBuffer pool_[HSM_TRACE_BUFFERS];
+		static std::atomic<std::size_t> count_{};
+
+		const std::size_t index_ = count_.fetch_add(1, std::memory_order_relaxed);
+		if (index_ >= HSM_TRACE_BUFFERS)
+		{
+			assert(!"hsm: the pool of trace buffers is exhausted");
+			__builtin_trap();
+		}
+
+		TraceBuffer *buffer_ = &pool_[index_];
+#else
+		TraceBuffer *buffer_ = new TraceBuffer;
+#endif
+
+		do
+		{
+			buffer_->next = head_;
+			buffer_->thread = static_cast<std::uint16_t>(head_ == nullptr ? 0 : head_->thread + 1);
+		}
+		while (!Trace::list().compare_exchange_weak(head_, buffer_, std::memory_order_release, std::memory_order_acquire));
+
+		return buffer_;
+	}
+};
+
+/* -------------------------------------------------------------------------- */
+
+}     //  namespace hsm
+
+#endif//__HSMTRACE_HPP
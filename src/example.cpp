@@ -1,6 +1,20 @@
 #include <hsm.hpp>
+#include <cstdint>
 #include <cstdio>
 
+#ifdef HSM_FREESTANDING
+#ifndef HSM_CYCLES
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HSM_CYCLES() static_cast<std::uint32_t>(__rdtsc())
+#elif defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+#define HSM_CYCLES() (*reinterpret_cast<volatile std::uint32_t *>(0xE0001004)) // DWT_CYCCNT, enabled by the startup code
+#else
+#define HSM_CYCLES() 0U
+#endif
+#endif
+#endif
+
 enum Event
 {
 	ALL   = hsm::Event::ALL,
@@ -66,20 +80,48 @@ auto vcr = hsm::StateMachine
 	{ StateRecordingPause,  Event::Rec,     StateRecordingRecord },
 }};
 
+#ifdef HSM_FREESTANDING
+struct Cycles
+{
+	std::uint32_t min = ~0U, max = 0, count = 0;
+	std::uint64_t sum = 0;
+} cycles;
+#endif
+
+void message( unsigned event )
+{
+#ifdef HSM_FREESTANDING
+	std::uint32_t start = HSM_CYCLES();
+	vcr.message({event});
+	std::uint32_t time = HSM_CYCLES() - start;
+	if (time < cycles.min) cycles.min = time;
+	if (time > cycles.max) cycles.max = time;
+	cycles.sum += time;
+	cycles.count++;
+#else
+	vcr.message({event});
+#endif
+}
+
 int main()
 {
 	vcr.start(StateOff);
-	vcr.message({Event::Power}); // Turn on the power
-	vcr.message({Event::Rew});   // Rewind to the beginning
-	vcr.message({Event::Stop});  // Beginning of tape, end of rewinding
-	vcr.message({Event::Play});  // Watching movie
-	vcr.message({Event::Pause}); // A little break
-	vcr.message({Event::Play});  // Resume watching a movie
-	vcr.message({Event::Stop});  // End of the movie
-	vcr.message({Event::Rew});   // Rewind to the beginning
-	vcr.message({Event::Stop});  // Beginning of tape, end of rewinding
-	vcr.message({Event::Rec});   // Now we're gonna record something
-	vcr.message({Event::Stop});  // End of recording
-	vcr.message({Event::Power}); // Turn off the power
-	vcr.message({Event::End});   // Stop state machine
+	message(Event::Power);   // Turn on the power
+	message(Event::Rew);     // Rewind to the beginning
+	message(Event::Stop);    // Beginning of tape, end of rewinding
+	message(Event::Play);    // Watching movie
+	message(Event::Pause);   // A little break
+	message(Event::Play);    // Resume watching a movie
+	message(Event::Stop);    // End of the movie
+	message(Event::Rew);     // Rewind to the beginning
+	message(Event::Stop);    // Beginning of tape, end of rewinding
+	message(Event::Rec);     // Now we're gonna record something
+	message(Event::Stop);    // End of recording
+	message(Event::Power);   // Turn off the power
+	message(Event::End);     // Stop state machine
+#ifdef HSM_FREESTANDING
+	std::printf("Dispatch cycles: min %lu, avg %lu, max %lu (%lu messages)\n",
+		static_cast<unsigned long>(cycles.min), static_cast<unsigned long>(cycles.sum / cycles.count),
+		static_cast<unsigned long>(cycles.max), static_cast<unsigned long>(cycles.count));
+#endif
 }
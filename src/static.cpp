@@ -0,0 +1,104 @@
+#include <hsmstatic.hpp>
+#include <cstdio>
+
+enum Event
+{
+	End   = hsm::Event::Stop,
+	Exit  = hsm::Event::Exit,
+	Entry = hsm::Event::Entry,
+	Init  = hsm::Event::Init,
+	Power = hsm::Event::User,
+	Stop,
+	Play,
+	Pause,
+	Rec,
+	Rew,
+	FF,
+};
+
+struct StateOff             : hsm::StaticState<> {};
+struct StateIdle            : hsm::StaticState<> {};
+struct StateIdleStop        : hsm::StaticState<StateIdle> {};
+struct StateIdleFF          : hsm::StaticState<StateIdle> {};
+struct StateIdleRew         : hsm::StaticState<StateIdle> {};
+struct StatePlaying         : hsm::StaticState<> {};
+struct StatePlayingPlay     : hsm::StaticState<StatePlaying> {};
+struct StatePlayingPause    : hsm::StaticState<StatePlaying> {};
+struct StateRecording       : hsm::StaticState<> {};
+struct StateRecordingRecord : hsm::StaticState<StateRecording> {};
+struct StateRecordingPause  : hsm::StaticState<StateRecording> {};
+
+template<const char *Text>
+void print( const hsm::Message& ) { puts(Text); }
+
+constexpr char EnterStandby[]   = "Enter standby mode";
+constexpr char ExitStandby[]    = "Exit standby mode";
+constexpr char EnterIdle[]      = "Enter idle";
+constexpr char ExitIdle[]       = "Exit idle";
+constexpr char GetReady[]       = "Get ready";
+constexpr char Rewind[]         = "Rewind";
+constexpr char FastForward[]    = "Fast forward";
+constexpr char EnterPlaying[]   = "Enter playing";
+constexpr char ExitPlaying[]    = "Exit playing";
+constexpr char Playing[]        = "Playing";
+constexpr char PlayingPause[]   = "Playing pause";
+constexpr char EnterRecording[] = "Enter recording";
+constexpr char ExitRecording[]  = "Exit recording";
+constexpr char Recording[]      = "Recording";
+constexpr char RecordingPause[] = "Recording pause";
+
+auto vcr = hsm::StaticStateMachine
+<
+	hsm::StaticHandler   <StateOff,             Event::Entry,   print<EnterStandby>>,
+	hsm::StaticHandler   <StateOff,             Event::Exit,    print<ExitStandby>>,
+	hsm::StaticTransition<StateOff,             Event::Power,   StateIdle>,
+	hsm::StaticHandler   <StateIdle,            Event::Entry,   print<EnterIdle>>,
+	hsm::StaticHandler   <StateIdle,            Event::Exit,    print<ExitIdle>>,
+	hsm::StaticTransition<StateIdle,            Event::Init,    StateIdleStop>,
+	hsm::StaticTransition<StateIdle,            Event::Power,   StateOff>,
+	hsm::StaticTransition<StateIdle,            Event::Play,    StatePlaying>,
+	hsm::StaticTransition<StateIdle,            Event::Rec,     StateRecording>,
+	hsm::StaticHandler   <StateIdleStop,        Event::Entry,   print<GetReady>>,
+	hsm::StaticTransition<StateIdleStop,        Event::Rew,     StateIdleRew>,
+	hsm::StaticTransition<StateIdleStop,        Event::FF,      StateIdleFF>,
+	hsm::StaticHandler   <StateIdleRew,         Event::Entry,   print<Rewind>>,
+	hsm::StaticTransition<StateIdleRew,         Event::Stop,    StateIdle>,
+	hsm::StaticHandler   <StateIdleFF,          Event::Entry,   print<FastForward>>,
+	hsm::StaticTransition<StateIdleFF,          Event::Stop,    StateIdle>,
+	hsm::StaticHandler   <StatePlaying,         Event::Entry,   print<EnterPlaying>>,
+	hsm::StaticHandler   <StatePlaying,         Event::Exit,    print<ExitPlaying>>,
+	hsm::StaticTransition<StatePlaying,         Event::Init,    StatePlayingPlay>,
+	hsm::StaticTransition<StatePlaying,         Event::Power,   StateOff>,
+	hsm::StaticTransition<StatePlaying,         Event::Stop,    StateIdle>,
+	hsm::StaticHandler   <StatePlayingPlay,     Event::Entry,   print<Playing>>,
+	hsm::StaticTransition<StatePlayingPlay,     Event::Pause,   StatePlayingPause>,
+	hsm::StaticHandler   <StatePlayingPause,    Event::Entry,   print<PlayingPause>>,
+	hsm::StaticTransition<StatePlayingPause,    Event::Play,    StatePlayingPlay>,
+	hsm::StaticHandler   <StateRecording,       Event::Entry,   print<EnterRecording>>,
+	hsm::StaticHandler   <StateRecording,       Event::Exit,    print<ExitRecording>>,
+	hsm::StaticTransition<StateRecording,       Event::Init,    StateRecordingRecord>,
+	hsm::StaticTransition<StateRecording,       Event::Power,   StateOff>,
+	hsm::StaticTransition<StateRecording,       Event::Stop,    StateIdle>,
+	hsm::StaticHandler   <StateRecordingRecord, Event::Entry,   print<Recording>>,
+	hsm::StaticTransition<StateRecordingRecord, Event::Pause,   StateRecordingPause>,
+	hsm::StaticHandler   <StateRecordingPause,  Event::Entry,   print<RecordingPause>>,
+	hsm::StaticTransition<StateRecordingPause,  Event::Rec,     StateRecordingRecord>
+>();
+
+int main()
+{
+	vcr.start<StateOff>();
+	vcr.message({Event::Power}); // Turn on the power
+	vcr.message({Event::Rew});   // Rewind to the beginning
+	vcr.message({Event::Stop});  // Beginning of tape, end of rewinding
+	vcr.message({Event::Play});  // Watching movie
+	vcr.message({Event::Pause}); // A little break
+	vcr.message({Event::Play});  // Resume watching a movie
+	vcr.message({Event::Stop});  // End of the movie
+	vcr.message({Event::Rew});   // Rewind to the beginning
+	vcr.message({Event::Stop});  // Beginning of tape, end of rewinding
+	vcr.message({Event::Rec});   // Now we're gonna record something
+	vcr.message({Event::Stop});  // End of recording
+	vcr.message({Event::Power}); // Turn off the power
+	vcr.message({Event::End});   // Stop state machine
+}
@@ -0,0 +1,122 @@
+#include <hsmprofile.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// usage: hsmgraph [-j] [-t top] image trace...
+// reads the hsm definition image written by hsm::Definition::save
+// and binary trace files written by hsm::Trace::save of the same build
+// prints the state tree and actions annotated with the observed frequency and latency,
+// the hottest actions, ancestor-walk misses and transition paths highlighted (DOT, -j: JSON)
+
+static bool image( const char *name_, std::vector<std::uint64_t>& data_, std::size_t& size_ )
+{
+	std::FILE *file_ = std::fopen(name_, "rb");
+	if (file_ == nullptr)
+	{
+		std::fprintf(stderr, "%s: cannot open the file\n", name_);
+		return false;
+	}
+
+	std::uint64_t block_;
+	std::size_t length_;
+	size_ = 0;
+	while ((length_ = std::fread(&block_, 1, sizeof(block_), file_)) > 0) // 8-byte aligned storage of the image
+	{
+		data_.push_back(block_);
+		size_ += length_;
+	}
+
+	std::fclose(file_);
+	return true;
+}
+
+static bool load( const char *name_, std::vector<hsm::TraceRecord>& records_, std::uint32_t& tick_ )
+{
+	std::FILE *file_ = std::fopen(name_, "rb");
+	if (file_ == nullptr)
+	{
+		std::fprintf(stderr, "%s: cannot open the file\n", name_);
+		return false;
+	}
+
+	hsm::TraceHeader header_;
+	bool result_ = std::fread(&header_, sizeof(header_), 1, file_) == 1 &&
+	               std::memcmp(header_.magic, hsm::TraceHeader{}.magic, sizeof(header_.magic)) == 0 &&
+	               header_.version == hsm::TraceHeader{}.version &&
+	               header_.size == sizeof(hsm::TraceRecord);
+
+	if (!result_)
+		std::fprintf(stderr, "%s: not a hsm trace file\n", name_);
+
+	for (std::uint64_t i = 0; result_ && i < header_.count; i++)
+	{
+		hsm::TraceRecord record_;
+		result_ = std::fread(&record_, sizeof(record_), 1, file_) == 1;
+		if (result_)
+			records_.push_back(record_);
+		else
+			std::fprintf(stderr, "%s: truncated file\n", name_);
+	}
+
+	if (tick_ == 0)
+		tick_ = header_.tick;
+
+	std::fclose(file_);
+	return result_;
+}
+
+int main( int argc, char *argv[] )
+{
+	std::vector<std::uint64_t> data_;
+	std::vector<hsm::TraceRecord> records_;
+	std::uint32_t tick_ = 0;
+	std::size_t size_ = 0;
+	std::size_t top_ = 5;
+	const char *name_ = nullptr;
+	bool json_ = false;
+	bool result_ = true;
+	int files_ = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "-j") == 0)
+			json_ = true;
+		else
+		if (std::strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+			top_ = std::strtoul(argv[++i], nullptr, 10);
+		else
+		if (name_ == nullptr)
+			name_ = argv[i];
+		else
+		{
+			result_ = load(argv[i], records_, tick_) && result_;
+			files_++;
+		}
+	}
+
+	if (files_ == 0)
+	{
+		std::fprintf(stderr, "usage: %s [-j] [-t top] image trace...\n", argv[0]);
+		return 2;
+	}
+
+	hsm::Definition def_;
+	if (!image(name_, data_, size_) || !def_.inspect(data_.data(), size_))
+	{
+		std::fprintf(stderr, "%s: not a hsm definition image of this build\n", name_);
+		return 1;
+	}
+
+	std::stable_sort(records_.begin(), records_.end(), []( const hsm::TraceRecord& a, const hsm::TraceRecord& b ){ return a.time < b.time; });
+
+	hsm::Profile profile_(def_, tick_ ? tick_ / 1000.0 : 1.0); // ticks to ns
+	profile_.add(records_.data(), records_.size());
+
+	if (!(json_ ? profile_.json(stdout, top_) : profile_.dot(stdout, top_)))
+		result_ = false;
+
+	return result_ ? 0 : 1;
+}
@@ -0,0 +1,96 @@
+#include <hsmtrace.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// usage: hsmtrace [-j] file...
+// decodes binary trace files written by hsm::Trace::save
+// prints one record per line, ordered by timestamp (-j: JSON lines)
+
+static const char *kinds[] = { "action", "unhandled", "transition", "exit", "entry", "init" };
+
+static const char *kind( std::uint16_t kind_ )
+{
+	return kind_ < sizeof(kinds) / sizeof(*kinds) ? kinds[kind_] : "unknown";
+}
+
+static bool load( const char *name_, std::vector<hsm::TraceRecord>& records_, std::uint32_t& tick_ )
+{
+	std::FILE *file_ = std::fopen(name_, "rb");
+	if (file_ == nullptr)
+	{
+		std::fprintf(stderr, "%s: cannot open the file\n", name_);
+		return false;
+	}
+
+	hsm::TraceHeader header_;
+	bool result_ = std::fread(&header_, sizeof(header_), 1, file_) == 1 &&
+	               std::memcmp(header_.magic, hsm::TraceHeader{}.magic, sizeof(header_.magic)) == 0 &&
+	               header_.version == hsm::TraceHeader{}.version &&
+	               header_.size == sizeof(hsm::TraceRecord);
+
+	if (!result_)
+		std::fprintf(stderr, "%s: not a hsm trace file\n", name_);
+
+	for (std::uint64_t i = 0; result_ && i < header_.count; i++)
+	{
+		hsm::TraceRecord record_;
+		result_ = std::fread(&record_, sizeof(record_), 1, file_) == 1;
+		if (result_)
+			records_.push_back(record_);
+		else
+			std::fprintf(stderr, "%s: truncated file\n", name_);
+	}
+
+	if (tick_ == 0)
+		tick_ = header_.tick;
+
+	std::fclose(file_);
+	return result_;
+}
+
+int main( int argc, char *argv[] )
+{
+	std::vector<hsm::TraceRecord> records_;
+	std::uint32_t tick_ = 0;
+	bool json_ = false;
+	bool result_ = true;
+	int files_ = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "-j") == 0)
+			json_ = true;
+		else
+		{
+			result_ = load(argv[i], records_, tick_) && result_;
+			files_++;
+		}
+	}
+
+	if (files_ == 0)
+	{
+		std::fprintf(stderr, "usage: %s [-j] file...\n", argv[0]);
+		return 2;
+	}
+
+	std::stable_sort(records_.begin(), records_.end(), []( const hsm::TraceRecord& a, const hsm::TraceRecord& b ){ return a.time < b.time; });
+
+	std::uint64_t start_ = records_.empty() ? 0 : records_.front().time;
+	const double scale_ = tick_ ? tick_ / 1000.0 : 1.0; // ticks to ns
+
+	for (const hsm::TraceRecord& r: records_)
+	{
+		double time_ = static_cast<double>(r.time - start_) * scale_;
+
+		if (json_)
+			std::printf("{\"time\": %.1f, \"thread\": %u, \"machine\": \"%#llx\", \"kind\": \"%s\", \"state\": %u, \"event\": %u, \"data\": %u}\n",
+				time_, r.thread, static_cast<unsigned long long>(r.machine), kind(r.kind), r.state, r.event, r.data);
+		else
+			std::printf("%14.1f %3u %#14llx %-10s state=%-5u event=%-5u data=%u\n",
+				time_, r.thread, static_cast<unsigned long long>(r.machine), kind(r.kind), r.state, r.event, r.data);
+	}
+
+	return result_ ? 0 : 1;
+}